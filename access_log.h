@@ -0,0 +1,76 @@
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Binary access log layout, shared by the server and pgs_logdump.
+//
+// A file is a sequence of 64-byte slots in host byte order. Slot 0 is the FileHeader, every
+// other slot starts a record: an access record, or a path definition followed by as many raw
+// slots as its text needs. Path ids are assigned per file, so every rotated file can be read on
+// its own; a definition is always written before the first record that uses its id. Slots that
+// are still all zero (never written, or the unused tail of a file that was not closed) are skipped.
+namespace AccessLogFormat
+{
+    constexpr char MAGIC[8] = {'P', 'G', 'S', 'A', 'C', 'C', '0', '1'};
+    constexpr uint32_t VERSION = 1;
+    constexpr size_t SLOT_SIZE = 64;
+
+    enum RecordType : uint8_t
+    {
+        Empty = 0,  // unused slot
+        Access = 1, // one served request
+        Path = 2,   // path text for an id
+    };
+
+    struct FileHeader
+    {
+        char magic[8];        // MAGIC
+        uint32_t version;     // VERSION
+        uint32_t slotSize;    // SLOT_SIZE
+        uint64_t createdUs;   // file creation, microseconds since the epoch
+        uint8_t reserved[40];
+    };
+
+    struct AccessRecord
+    {
+        uint8_t type;         // RecordType::Access
+        uint8_t cacheHit;     // 1 when the body came from the in-memory cache
+        uint8_t encoding;     // content coding of the body, index into ENCODINGS
+        uint8_t reserved0;
+        uint16_t status;      // HTTP status code sent
+        uint16_t reserved1;
+        uint32_t pathId;      // id of a Path record earlier in the file
+        uint32_t latencyUs;   // request parsed to last byte handed to the socket
+        uint64_t timestampUs; // request start, microseconds since the epoch
+        uint64_t bytes;       // bytes written for the response, headers included
+        uint8_t address[16];  // client address, IPv4 clients as ::ffff:a.b.c.d
+        uint8_t reserved2[16];
+    };
+
+    struct PathRecord
+    {
+        uint8_t type;         // RecordType::Path
+        uint8_t reserved;
+        uint16_t length;      // path bytes, text continues in the slots that follow
+        uint32_t pathId;
+        char text[56];        // first bytes of the path
+    };
+
+    static_assert(sizeof(FileHeader) == SLOT_SIZE, "header fills one slot");
+    static_assert(sizeof(AccessRecord) == SLOT_SIZE, "access records fill one slot");
+    static_assert(sizeof(PathRecord) == SLOT_SIZE, "path records start with one slot");
+
+    // Content-Encoding tokens by AccessRecord::encoding, same order as the server's ContentEncoding
+    constexpr const char *ENCODINGS[] = {"identity", "gzip", "br", "zstd"};
+    constexpr size_t ENCODING_COUNT = sizeof(ENCODINGS) / sizeof(ENCODINGS[0]);
+
+    // slots a path definition of length bytes occupies
+    constexpr size_t pathSlots(size_t length)
+    {
+        return length <= sizeof(PathRecord::text) ? 1 : 1 + (length - sizeof(PathRecord::text) + SLOT_SIZE - 1) / SLOT_SIZE;
+    }
+}
+
+#endif // ACCESS_LOG_H
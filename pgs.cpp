@@ -1,6 +1,7 @@
 #include <iostream>           // std::cout, std::cerr - for console output
 #include <cstring>            // strlen() - for string manipulation
 #include <sys/socket.h>       // socket(), bind(), listen(), accept() - for socket operations
+#include <sys/un.h>           // sockaddr_un - for the syslog socket
 #include <sys/sendfile.h>     // sendfile - for efficient file sending
 #include <sys/stat.h>         // fstat - to get file status
 #include <sys/uio.h>          // writev - to write to multiple buffers
@@ -10,14 +11,18 @@
 #include <netinet/in.h>       // sockaddr_in - structure for IPv4 addresses
 #include <unistd.h>           // close() function - to close file descriptors
 #include <sys/epoll.h>        // epoll - for scalable I/O event notification
+#include <sys/resource.h>     // getrlimit - to size the connection table
+#include <sys/inotify.h>      // inotify - for watching the static folder
+#include <poll.h>             // poll - for waiting on the inotify descriptor
+#include <pthread.h>          // pthread_setaffinity_np - for pinning reactors to cores
 #include <fstream>            // file reading operations
 #include <sstream>            // string stream manipulations
 #include <filesystem>         // filesystem operations
 #include <ctime>              // handling timestamps
 #include <fcntl.h>            // file control options
-#include <map>                // ordered associative container (Red-Black Tree)
 #include <set>                // ordered unique elements (Red-Black Tree)
 #include <deque>              // double-ended queue
+#include <random>             // multipart boundaries
 #include <list>               // doubly linked list for cache implementation
 #include <thread>             // multithreading support
 #include <vector>             // dynamic array
@@ -31,18 +36,32 @@
 #include <chrono>             // measuring time
 #include <shared_mutex>       // shared mutexes
 #include <memory>             // smart pointers
+#include <optional>           // optional values
 #include <memory_resource>    // memory resource management
 #include <array>              // fixed-size arrays
+#include <bit>                // std::bit_ceil
 #include <string_view>        // efficient string handling without ownership
 #include <new>                // memory alignment
 #include <future>             // asynchronous tasks
 #include <csignal>            // signal handling
 #include <atomic>             // atomic operations
 #include <zlib.h>             // zlib compression
+#ifdef PGS_WITH_BROTLI
+#include <brotli/encode.h>    // brotli compression, enabled by the Makefile when libbrotlienc is found
+#endif
+#ifdef PGS_WITH_ZSTD
+#include <zstd.h>             // zstd compression, enabled by the Makefile when libzstd is found
+#endif
+#include <cctype>             // isalnum - for request token validation
+#include <limits>             // std::numeric_limits
+#if defined(__SSE2__)
+#include <emmintrin.h>        // SSE2 intrinsics - for scanning request heads
+#endif
 #include <stdexcept>          // standard exceptions like std::runtime_error
 #include <nlohmann/json.hpp>  // JSON parsing
 
 #include "terminal_utils.h"
+#include "access_log.h"
 
 namespace fs = std::filesystem; // Alias for filesystem namespace
 using json = nlohmann::json;    // Alias for JSON namespace
@@ -52,6 +71,7 @@ struct Config
     int port;                 // prot for server
     std::string staticFolder; // path for static files
     int threadCount;          // thread count of worker threads
+    bool reactorPerCore;      // run one accept/epoll loop per worker instead of a shared dispatcher
     struct
     {
         int maxRequests; // maximum number of requests allowed within time window
@@ -61,430 +81,2824 @@ struct Config
     {
         size_t sizeMB;     // maximum size of cache in MB
         int maxAgeSeconds; // maximum age of cache entries in seconds
+        std::string snapshot; // file the cache is saved to on shutdown and restored from on boot, empty disables
+        bool admission;       // TinyLFU admission filter, false admits everything that fits
     } cache;
+    struct
+    {
+        size_t maxEntries; // open descriptors kept for served paths
+        int revalidateMs;  // interval after which a cached descriptor is checked against the path again
+    } fileCache;
+    struct
+    {
+        bool enabled;         // fill the cache before accepting connections
+        std::string manifest; // request paths to load, hottest first; empty walks the static folder
+        int deadlineMs;       // stop waiting for warm-up after this long
+    } warmup;
+    struct
+    {
+        int gzipLevel;   // zlib level 1-9
+        int brotliLevel; // brotli quality 0-11
+        int zstdLevel;   // zstd level 1-22
+    } compression;
+    struct
+    {
+        std::string path; // binary access log file, empty disables
+        size_t maxMB;     // size at which the file is rotated
+        int keep;         // rotated files kept as path.1 ... path.<keep>
+    } accessLog;
+    struct
+    {
+        std::string level;  // lowest level logged: debug, info, success, warning or error
+        std::string file;   // log file, empty disables
+        bool console;       // colored lines on stdout
+        std::string syslog; // unix datagram socket of a syslog daemon such as /dev/log, empty disables
+    } logging;
 };
 
-// Connection information structure
-struct ConnectionInfo
+// SIMD fast path for scanning request heads, falls back to memchr without SSE2
+template <char C>
+[[nodiscard]] inline const char *findByte(const char *p, const char *end) noexcept
 {
-    std::chrono::steady_clock::time_point startTime; // connection start time
-    std::string ip;                                  // client IP address
-    bool isLogged;                                   // flag to track if connection is logged
-    bool isClosureLogged;                            // flag to track if connection closure is logged
-    uint64_t bytesReceived;                          // bytes received from client
-    uint64_t bytesSent;                              // bytes sent to client
-    std::vector<std::string> logBuffer;              // buffer for storing logs
+#if defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(C);
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    const void *hit = memchr(p, C, end - p);
+    return hit ? static_cast<const char *>(hit) : end;
+}
 
-    ConnectionInfo(const std::chrono::steady_clock::time_point &time,
-                   const std::string &ipAddr,
-                   bool logged = false,
-                   bool closureLogged = false,
-                   uint64_t received = 0,
-                   uint64_t sent = 0)
-        : startTime(time), ip(ipAddr), isLogged(logged),
-          isClosureLogged(closureLogged), bytesReceived(received),
-          bytesSent(sent) {}
-};
-class Logger
+// Parsed request, every view points into the connection's read buffer
+// and stays valid until the request is consumed from the parser
+struct HttpRequest
 {
-private:
-    // basic logger members
-    std::mutex logMutex;   // mutex to protect log file access
-    std::ofstream logFile; // log file stream
-    static Logger *instance;
-    bool isWaitingForEvents;                                                 // new flag to track event waiting state
-    std::chrono::steady_clock::time_point lastEventWaitLog;                  // track last event wait log time
-    static constexpr auto EVENT_WAIT_LOG_INTERVAL = std::chrono::seconds(5); // log interval for waiting events
-
-    // structure to hold log message data
-    struct LogMessage
+    struct Header
     {
-        std::string message;                             // actual log message
-        std::string level;                               // log level (INFO, ERROR, etc.)
-        std::string ip;                                  // iP address associated with log
-        std::chrono::system_clock::time_point timestamp; // when log was created
-
-        LogMessage(const std::string &msg, const std::string &lvl, const std::string &clientIp)
-            : message(msg), level(lvl), ip(clientIp),
-              timestamp(std::chrono::system_clock::now()) {}
+        std::string_view name;  // header field name as sent
+        std::string_view value; // field value without surrounding whitespace
     };
-
-    // async logging members
-    std::queue<LogMessage> messageQueue; // queue to store pending log messages
-    std::mutex queueMutex;               // mutex to protect message queue
-    std::condition_variable queueCV;     // condition variable for queue synchronization
-    std::thread loggerThread;            // background thread for processing logs
-    std::atomic<bool> running{true};     // flag to control background thread
-
-    Logger() : isWaitingForEvents(false)
+    static constexpr size_t MAX_HEADERS = 64; // header fields accepted per request
+
+    std::string_view method;                 // request method token
+    std::string_view target;                 // request target as sent (path + query)
+    std::string_view path;                   // target without query string or fragment
+    std::string_view version;                // HTTP/1.0 or HTTP/1.1
+    std::array<Header, MAX_HEADERS> headers; // header fields in arrival order
+    size_t headerCount = 0;                  // number of valid entries in headers
+    size_t contentLength = 0;                // request body length
+    size_t length = 0;                       // head plus body bytes in the read buffer
+    std::string_view raw;                    // whole request (head + body)
+
+    // case-insensitive header lookup, empty view if absent
+    [[nodiscard]] std::string_view header(std::string_view name) const noexcept
     {
-        logFile.open("pgs.log", std::ios::app); // open log file in append mode
-        // start background logging thread
-        loggerThread = std::thread(&Logger::processLogs, this);
-        // deliberately don't call info() here to avoid recursion
-        writeLogMessage(LogMessage("Logger initialized", "SUCCESS", "-"));
+        for (size_t i = 0; i < headerCount; ++i)
+        {
+            if (equalsIgnoreCase(headers[i].name, name))
+            {
+                return headers[i].value;
+            }
+        }
+        return {};
     }
 
-    // process logs in background thread
-    void processLogs()
+    // HTTP/1.1 is persistent unless the client says otherwise, HTTP/1.0 must opt in
+    [[nodiscard]] bool keepAlive() const noexcept
     {
-        while (running)
+        std::string_view connection = header("Connection");
+        if (version == "HTTP/1.0")
         {
-            std::vector<LogMessage> messages; // batch of log messages to write
-            {
-                // wait for new messages or shutdown signal
-                std::unique_lock<std::mutex> lock(queueMutex);
-                queueCV.wait_for(lock, std::chrono::seconds(1),
-                                 [this]
-                                 { return !messageQueue.empty() || !running; });
+            return containsIgnoreCase(connection, "keep-alive");
+        }
+        return !containsIgnoreCase(connection, "close");
+    }
 
-                // batch process up to 100 messages at once for better performance
-                while (!messageQueue.empty() && messages.size() < 100)
-                {
-                    messages.push_back(std::move(messageQueue.front()));
-                    messageQueue.pop();
-                }
-            }
+    [[nodiscard]] static bool equalsIgnoreCase(std::string_view a, std::string_view b) noexcept
+    {
+        return a.size() == b.size() &&
+               std::equal(a.begin(), a.end(), b.begin(),
+                          [](char x, char y)
+                          { return ::tolower(static_cast<unsigned char>(x)) == ::tolower(static_cast<unsigned char>(y)); });
+    }
 
-            // write batched messages to file
-            if (!messages.empty())
+    [[nodiscard]] static bool containsIgnoreCase(std::string_view haystack, std::string_view needle) noexcept
+    {
+        for (size_t i = 0; i + needle.size() <= haystack.size(); ++i)
+        {
+            if (equalsIgnoreCase(haystack.substr(i, needle.size()), needle))
             {
-                std::lock_guard<std::mutex> lock(logMutex);
-                for (const auto &msg : messages)
-                {
-                    writeLogMessage(msg);
-                }
-                logFile.flush();
+                return true;
             }
         }
+        return false;
     }
+};
+
+// Incremental HTTP/1.x request parser over a per-connection read buffer
+// bytes are read straight into the buffer, requests are parsed in place without copying
+class RequestParser
+{
+public:
+    static constexpr size_t MAX_HEAD_SIZE = 8192;   // request line plus headers
+    static constexpr size_t MAX_BODY_SIZE = 65536;  // request bodies are skipped, but must be bounded
+    static constexpr size_t READ_CHUNK = 16384;     // free space reserved for each read()
+    static constexpr size_t READ_LIMIT = MAX_HEAD_SIZE + MAX_BODY_SIZE; // stop reading once this much is buffered
 
-    // format and write a single log message
-    void writeLogMessage(const LogMessage &msg)
+    enum class Status
     {
-        std::string logMessage = formatLogMessage(msg);
+        Complete,     // a request has been parsed
+        Incomplete,   // need more bytes
+        Invalid,      // malformed request (400)
+        HeadTooLarge, // head or header count over limit (431)
+        BodyTooLarge, // body over limit (413)
+        Unsupported   // transfer coding we don't implement (501)
+    };
 
-        logFile << logMessage << std::endl;
+    RequestParser() = default;
+    RequestParser(RequestParser &&) noexcept = default;
+    RequestParser &operator=(RequestParser &&) noexcept = default;
 
-        // Output to console with appropriate color
-        if (msg.level == "ERROR")
-        {
-            std::cout << TerminalUtils::error(logMessage) << std::endl;
-        }
-        else if (msg.level == "WARNING")
-        {
-            std::cout << TerminalUtils::warning(logMessage) << std::endl;
-        }
-        else if (msg.level == "SUCCESS")
+    // space for the next read(), compacts or grows the buffer, invalidates parsed views
+    [[nodiscard]] char *prepareRead(size_t minSpace)
+    {
+        if (begin > 0 && capacity - end < minSpace)
         {
-            std::cout << TerminalUtils::success(logMessage) << std::endl;
+            memmove(data.get(), data.get() + begin, end - begin);
+            end -= begin;
+            begin = 0;
         }
-        else
+        if (capacity - end < minSpace)
         {
-            std::cout << TerminalUtils::info(logMessage) << std::endl;
+            size_t newCapacity = std::max(capacity * 2, end + minSpace);
+            std::unique_ptr<char[]> grown(new char[newCapacity]);
+            if (end > 0)
+            {
+                memcpy(grown.get(), data.get(), end);
+            }
+            data = std::move(grown);
+            capacity = newCapacity;
         }
+        return data.get() + end;
     }
 
-    // format timestamp and log message
-    [[nodiscard]]
-    std::string formatLogMessage(const LogMessage &msg)
-    {
-        auto time = std::chrono::system_clock::to_time_t(msg.timestamp);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                      msg.timestamp.time_since_epoch()) %
-                  1000;
-
-        char timestamp[32]; // buffer for timestamp
-        std::strftime(timestamp, sizeof(timestamp), "[%Y-%m-%d %H:%M:%S]",
-                      std::localtime(&time)); // format timestamp
+    void commitRead(size_t bytes) noexcept { end += bytes; }
 
-        return std::string(timestamp) + "." + std::to_string(ms.count()) +
-               " [" + msg.level + "] [" + msg.ip + "] " + msg.message;
-    }
+    [[nodiscard]] size_t buffered() const noexcept { return end - begin; }
 
-public:
-    // singleton pattern implementation
-    static Logger *getInstance()
+    // drop a fully handled request from the front of the buffer
+    void consume(size_t bytes) noexcept
     {
-        if (instance == nullptr)
+        begin += std::min(bytes, end - begin);
+        scanned = 0;
+        if (begin == end)
         {
-            instance = new Logger();
+            begin = end = 0;
         }
-        return instance;
     }
 
-    static void destroyInstance() // clean up
+    // discard everything buffered, e.g. after the connection is marked for close
+    void clear() noexcept
     {
-        delete instance;
-        instance = nullptr;
+        begin = end = scanned = 0;
     }
 
-    // ensure proper cleanup in destructor
-    ~Logger()
+    [[nodiscard]] Status next(HttpRequest &request)
     {
-        running = false;      // signal background thread to stop
-        queueCV.notify_one(); // wake up background thread
+        const char *base = data.get() + begin;
+        const char *limit = base + (end - begin);
 
-        if (loggerThread.joinable())
+        // tolerate stray CRLFs between pipelined requests
+        while (limit - base >= 2 && base[0] == '\r' && base[1] == '\n')
         {
-            loggerThread.join(); // wait for background thread to finish
+            base += 2;
+            begin += 2;
+        }
+        const size_t available = static_cast<size_t>(limit - base);
+
+        // find end of head, resuming where the previous partial read stopped
+        const char *headEnd = nullptr;
+        const char *p = base + std::min(scanned, available);
+        while ((p = findByte<'\r'>(p, limit)) != limit && limit - p >= 4)
+        {
+            if (p[1] == '\n' && p[2] == '\r' && p[3] == '\n')
+            {
+                headEnd = p + 4;
+                break;
+            }
+            ++p;
+        }
+        if (!headEnd)
+        {
+            if (available > MAX_HEAD_SIZE)
+            {
+                return Status::HeadTooLarge;
+            }
+            scanned = available >= 3 ? available - 3 : 0; // CRLFCRLF may straddle the next read
+            return Status::Incomplete;
         }
 
-        if (logFile.is_open())
+        const size_t headSize = static_cast<size_t>(headEnd - base);
+        if (headSize > MAX_HEAD_SIZE)
         {
-            logFile.close();
+            return Status::HeadTooLarge;
         }
-    }
 
-    // main logging function
-    void log(const std::string &message, const std::string &level = "INFO", const std::string &ip = "-")
-    {
-        // handle special case for "Waiting for events" messages
-        if (message == "Waiting for events...")
+        request.headerCount = 0;
+        request.contentLength = 0;
+
+        // request line: method SP target SP version CRLF
+        const char *lineEnd = findByte<'\r'>(base, headEnd);
+        if (lineEnd[1] != '\n')
         {
-            std::lock_guard<std::mutex> lock(logMutex);
-            auto now = std::chrono::steady_clock::now();
+            return Status::Invalid; // bare CR
+        }
+        std::string_view line(base, lineEnd - base);
+        size_t firstSpace = line.find(' ');
+        size_t secondSpace = firstSpace == std::string_view::npos ? firstSpace : line.find(' ', firstSpace + 1);
+        if (secondSpace == std::string_view::npos)
+        {
+            return Status::Invalid;
+        }
+        request.method = line.substr(0, firstSpace);
+        request.target = line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+        request.version = line.substr(secondSpace + 1);
+        if (!isToken(request.method) || !validTarget(request.target) ||
+            (request.version != "HTTP/1.1" && request.version != "HTTP/1.0"))
+        {
+            return Status::Invalid;
+        }
+        request.path = request.target.substr(0, request.target.find_first_of("?#"));
 
-            if (!isWaitingForEvents ||
-                (now - lastEventWaitLog) >= EVENT_WAIT_LOG_INTERVAL) // check if interval has passed
+        // header fields: name ":" OWS value OWS CRLF
+        bool hasContentLength = false;
+        for (const char *cursor = lineEnd + 2; cursor < headEnd - 2; cursor = lineEnd + 2)
+        {
+            lineEnd = findByte<'\r'>(cursor, headEnd);
+            if (lineEnd[1] != '\n')
             {
-                isWaitingForEvents = true;
-                lastEventWaitLog = now;
+                return Status::Invalid; // bare CR
             }
-            else
+            if (*cursor == ' ' || *cursor == '\t')
             {
-                return; // skip logging if we're already waiting and interval hasn't passed
+                return Status::Invalid; // obsolete line folding
+            }
+
+            const char *colon = findByte<':'>(cursor, lineEnd);
+            if (colon == lineEnd)
+            {
+                return Status::Invalid;
+            }
+            std::string_view name(cursor, colon - cursor);
+            std::string_view value(colon + 1, lineEnd - colon - 1);
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+                value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+                value.remove_suffix(1);
+            if (!isToken(name))
+            {
+                return Status::Invalid;
+            }
+            if (request.headerCount == HttpRequest::MAX_HEADERS)
+            {
+                return Status::HeadTooLarge;
+            }
+            request.headers[request.headerCount++] = {name, value};
+
+            if (HttpRequest::equalsIgnoreCase(name, "Transfer-Encoding"))
+            {
+                return Status::Unsupported; // chunked request bodies are not supported
+            }
+            if (HttpRequest::equalsIgnoreCase(name, "Content-Length"))
+            {
+                size_t length = 0;
+                if (value.empty() || !parseLength(value, length) ||
+                    (hasContentLength && length != request.contentLength))
+                {
+                    return Status::Invalid;
+                }
+                hasContentLength = true;
+                request.contentLength = length;
             }
         }
-        else
+
+        if (request.contentLength > MAX_BODY_SIZE)
         {
-            isWaitingForEvents = false; // reset waiting flag
+            return Status::BodyTooLarge;
         }
-
-        // queue log message for async processing
+        if (available < headSize + request.contentLength)
         {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            messageQueue.emplace(message, level, ip);
+            scanned = headSize - 4; // head is complete, only wait for the body
+            return Status::Incomplete;
         }
-        queueCV.notify_one(); // notify background thread
-    }
 
-    // convenience methods for different log levels
-    void error(const std::string &message, const std::string &ip = "-")
-    {
-        log(message, "ERROR", ip);
+        request.length = headSize + request.contentLength;
+        request.raw = std::string_view(base, request.length);
+        return Status::Complete;
     }
 
-    void warning(const std::string &message, const std::string &ip = "-")
+private:
+    std::unique_ptr<char[]> data; // receive buffer
+    size_t capacity = 0;          // allocated bytes
+    size_t begin = 0;             // first unconsumed byte
+    size_t end = 0;               // one past last received byte
+    size_t scanned = 0;           // bytes after begin already searched for end of head
+
+    [[nodiscard]] static bool isToken(std::string_view s) noexcept
     {
-        log(message, "WARNING", ip);
+        // tchar from RFC 9110
+        static constexpr std::string_view extra = "!#$%&'*+-.^_`|~";
+        return !s.empty() &&
+               std::all_of(s.begin(), s.end(), [](char c)
+                           { return std::isalnum(static_cast<unsigned char>(c)) || extra.find(c) != std::string_view::npos; });
     }
 
-    void success(const std::string &message, const std::string &ip = "-")
+    // origin-form only, no control characters and no ".." segments escaping the static folder
+    [[nodiscard]] static bool validTarget(std::string_view target) noexcept
     {
-        log(message, "SUCCESS", ip);
+        if (target.empty() || target.front() != '/')
+        {
+            return false;
+        }
+        if (std::any_of(target.begin(), target.end(), [](char c)
+                        { return static_cast<unsigned char>(c) <= 0x20 || c == 0x7f; }))
+        {
+            return false;
+        }
+        std::string_view path = target.substr(0, target.find_first_of("?#"));
+        for (size_t pos = path.find("/.."); pos != std::string_view::npos; pos = path.find("/..", pos + 1))
+        {
+            if (pos + 3 == path.size() || path[pos + 3] == '/')
+            {
+                return false;
+            }
+        }
+        return true;
     }
 
-    void info(const std::string &message, const std::string &ip = "-")
+    [[nodiscard]] static bool parseLength(std::string_view value, size_t &length) noexcept
     {
-        log(message, "INFO", ip);
+        length = 0;
+        for (char c : value)
+        {
+            if (c < '0' || c > '9' || length > (std::numeric_limits<size_t>::max() - 9) / 10)
+            {
+                return false;
+            }
+            length = length * 10 + static_cast<size_t>(c - '0');
+        }
+        return true;
     }
 };
 
-Logger *Logger::instance = nullptr; // initialize static singleton instance
+class EpollWrapper; // forward declaration for ConnectionInfo
+struct SendState;   // forward declaration for ConnectionInfo
 
-class Cache
+// Connection information structure
+struct ConnectionInfo
 {
-private:
-    // Cache entry structure for storing file content and metadata - O(1) access time
-    struct CacheEntry
+    std::chrono::steady_clock::time_point startTime; // connection start time
+    std::string ip;                                  // client IP address
+    bool isLogged;                                   // flag to track if connection is logged
+    bool isClosureLogged;                            // flag to track if connection closure is logged
+    uint64_t bytesReceived;                          // bytes received from client
+    uint64_t bytesSent;                              // bytes sent to client
+    std::vector<std::string> logBuffer;              // buffer for storing logs
+    EpollWrapper *epoll = nullptr;                   // epoll instance that owns this connection
+    std::shared_ptr<SendState> sendState;            // response parked on EAGAIN, resumed on EPOLLOUT
+    RequestParser parser;                            // read buffer and parse state for pipelined requests
+    uint32_t requestCount = 0;                       // requests served on this (keep-alive) connection
+    std::chrono::steady_clock::time_point lastActivity; // last read/write activity, for keep-alive timeout
+    struct in6_addr address{};                       // binary client address
+    bool scheduled = false;                          // a worker owns the connection, its socket is disarmed until released
+    bool writeArmed = false;                         // EPOLLOUT is part of the socket's interest set
+
+    // request whose response is still being written, recorded in the access log once it is done
+    struct PendingAccess
     {
-        std::vector<char> data;                       // actual content of cached file
-        std::string mimeType;                         // MIME type of cached content
-        time_t lastModified;                          // last modification time of file
-        std::list<std::string>::iterator lruIterator; // iterator pointing to key's position in LRU list
-
-        CacheEntry() : lastModified(0) {}
-
-        // constructor for standard vector - O(n) for data copy
-        CacheEntry(const std::vector<char> &d, const std::string &m, time_t lm,
-                   std::list<std::string>::iterator it)
-            : data(d), mimeType(m), lastModified(lm), lruIterator(it) {}
-
-        // constructor for any vector-like container - O(n) for data copy
-        template <typename Vector>
-        CacheEntry(const Vector &d, const std::string &m, time_t lm,
-                   std::list<std::string>::iterator it)
-            : data(d.begin(), d.end()), mimeType(m), lastModified(lm), lruIterator(it) {}
-    };
+        bool active = false;
+        std::string path;                                 // request path, capacity reused across requests
+        std::chrono::system_clock::time_point start;      // wall clock at request start
+        std::chrono::steady_clock::time_point started;    // for the latency
+        uint64_t bytesBefore = 0;                         // SendState::bytesSent at request start
+    } access;
 
-    std::unordered_map<std::string, CacheEntry> cache; // main cache storage (key -> entry mapping)
-    std::list<std::string> lruList;                    // LRU order tracking list (most recent -> least recent)
-    mutable std::shared_mutex mutex;                   // mutex for thread-safe operations
-    size_t maxSize;                                    // maximum size of cache in bytes
-    size_t currentSize;                                // current size of cache in bytes
-    std::chrono::seconds maxAge;                       // maximum age of cache entries
+    ConnectionInfo(const std::chrono::steady_clock::time_point &time,
+                   const std::string &ipAddr,
+                   bool logged = false,
+                   bool closureLogged = false,
+                   uint64_t received = 0,
+                   uint64_t sent = 0)
+        : startTime(time), ip(ipAddr), isLogged(logged),
+          isClosureLogged(closureLogged), bytesReceived(received),
+          bytesSent(sent), lastActivity(time) {}
+};
 
-    // helper function to update LRU order - O(1) operation
-    void updateLRU(const std::string &key)
+// Connection table indexed by socket descriptor. Descriptors are small dense integers, so a lookup
+// is two array loads; slots live in fixed pages allocated on first use and never moved or freed.
+// Each slot has its own lock for the fields the event loop shares with the owner (scheduling,
+// activity, open/close); everything else belongs to whichever thread currently owns the connection
+class ConnectionTable
+{
+public:
+    struct Slot
     {
-        lruList.erase(cache[key].lruIterator);    // remove from current position
-        lruList.push_front(key);                  // add to front (most recently used)
-        cache[key].lruIterator = lruList.begin(); // update iterator
-    }
+        std::mutex mutex;                   // guards info's lifetime, scheduled and lastActivity
+        std::optional<ConnectionInfo> info; // engaged while the descriptor is an open connection
+    };
 
-public:
-    // constructor with overflow check - O(1)
-    explicit Cache(size_t maxSizeMB, std::chrono::seconds maxAge)
-        : maxSize(static_cast<size_t>(maxSizeMB) * 1024 * 1024),
-          currentSize(0),
-          maxAge(maxAge)
+    // sized to the process descriptor limit, accept can't return anything above it
+    ConnectionTable()
     {
-        // check for cache size overflow
-        if (maxSize / (1024 * 1024) != maxSizeMB) // calculate: 1024*1024=1048576(1MB)
+        struct rlimit limit;
+        size_t descriptors = 65536;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
         {
-            throw std::overflow_error("Cache size overflow");
+            descriptors = static_cast<size_t>(limit.rlim_cur);
         }
+        pageCount = (descriptors + PAGE_SLOTS - 1) / PAGE_SLOTS;
+        pages = std::make_unique<std::atomic<Page *>[]>(pageCount);
     }
 
-    // retrieve an item from cache - O(1) average case
-    template <typename Vector>
-    bool get(const std::string &key, Vector &data, std::string &mimeType, time_t &lastModified)
+    ~ConnectionTable()
     {
-        std::shared_lock<std::shared_mutex> lock(mutex);
-        auto it = cache.find(key);
-        if (it != cache.end())
+        for (size_t i = 0; i < pageCount; ++i)
         {
-            data.assign(it->second.data.begin(), it->second.data.end());
-            mimeType = it->second.mimeType;
-            lastModified = it->second.lastModified;
-
-            // update LRU order under exclusive lock
-            lock.unlock();
-            std::unique_lock<std::shared_mutex> uniqueLock(mutex);
-            updateLRU(key);
-            return true;
+            delete pages[i].load(std::memory_order_relaxed);
         }
-        return false; // cache miss
     }
 
-    // add or update an item in cache - O(1) average case
-    template <typename Vector>
-    void set(const std::string &key, const Vector &data,
-             const std::string &mimeType, time_t lastModified)
-    {
-        std::unique_lock<std::shared_mutex> lock(mutex);
+    ConnectionTable(const ConnectionTable &) = delete;
+    ConnectionTable &operator=(const ConnectionTable &) = delete;
 
-        // if entry already exists, remove it first
-        auto it = cache.find(key);
-        if (it != cache.end())
+    // slot of an open descriptor, nullptr when its page was never needed
+    Slot *find(int fd) const
+    {
+        if (fd < 0 || static_cast<size_t>(fd) / PAGE_SLOTS >= pageCount)
         {
-            currentSize -= it->second.data.size();
-            lruList.erase(it->second.lruIterator);
-            cache.erase(it);
+            return nullptr;
         }
+        Page *page = pages[fd / PAGE_SLOTS].load(std::memory_order_acquire);
+        return page ? &page->slots[fd % PAGE_SLOTS] : nullptr;
+    }
 
-        // if new entry is too large, don't cache it
-        if (data.size() > maxSize)
+    // slot for a newly accepted descriptor, allocates its page if needed
+    Slot *acquire(int fd)
+    {
+        if (fd < 0 || static_cast<size_t>(fd) / PAGE_SLOTS >= pageCount)
         {
-            return;
+            return nullptr;
         }
-
-        // remove least recently used entries until we have enough space
-        while (!lruList.empty() && currentSize + data.size() > maxSize)
+        std::atomic<Page *> &entry = pages[fd / PAGE_SLOTS];
+        Page *page = entry.load(std::memory_order_acquire);
+        if (!page)
         {
-            const std::string &lruKey = lruList.back();
-            currentSize -= cache[lruKey].data.size();
-            cache.erase(lruKey);
-            lruList.pop_back();
+            // reactors accept concurrently, the first one to publish a page wins
+            Page *fresh = new Page();
+            if (entry.compare_exchange_strong(page, fresh, std::memory_order_acq_rel))
+            {
+                page = fresh;
+            }
+            else
+            {
+                delete fresh;
+            }
         }
+        return &page->slots[fd % PAGE_SLOTS];
+    }
 
-        // add new entry to front of LRU list and cache
-        lruList.push_front(key);
-        try
-        {
-            cache.emplace(key, CacheEntry(data, mimeType, lastModified, lruList.begin()));
-            currentSize += data.size();
-        }
-        catch (const std::exception &e)
+    // visit every open connection under its slot lock
+    template <typename Visitor>
+    void forEach(Visitor &&visitor)
+    {
+        for (size_t i = 0; i < pageCount; ++i)
         {
-            lruList.pop_front(); // rollback on failure
-            Logger::getInstance()->error("Cache allocation failed: " + std::string(e.what()));
+            Page *page = pages[i].load(std::memory_order_acquire);
+            if (!page)
+            {
+                continue;
+            }
+            for (size_t j = 0; j < PAGE_SLOTS; ++j)
+            {
+                Slot &slot = page->slots[j];
+                std::lock_guard<std::mutex> lock(slot.mutex);
+                if (slot.info)
+                {
+                    visitor(static_cast<int>(i * PAGE_SLOTS + j), *slot.info);
+                }
+            }
         }
     }
 
-    // clear all items from cache - O(1)
-    void clear()
+private:
+    static constexpr size_t PAGE_SLOTS = 256;
+
+    struct Page
     {
-        std::unique_lock<std::shared_mutex> lock(mutex);
-        cache.clear();
-        lruList.clear();
-        currentSize = 0;
+        Slot slots[PAGE_SLOTS];
+    };
+
+    std::unique_ptr<std::atomic<Page *>[]> pages;
+    size_t pageCount = 0;
+};
+
+// server-wide traffic totals: every thread adds to its own cache line, the cells
+// are only summed when someone asks for the totals
+class TrafficCounters
+{
+public:
+    struct Totals
+    {
+        uint64_t connections = 0;
+        uint64_t bytesReceived = 0;
+        uint64_t bytesSent = 0;
+    };
+
+    void add(uint64_t connections, uint64_t received, uint64_t sent)
+    {
+        Cell &cell = local();
+        cell.connections.fetch_add(connections, std::memory_order_relaxed);
+        cell.bytesReceived.fetch_add(received, std::memory_order_relaxed);
+        cell.bytesSent.fetch_add(sent, std::memory_order_relaxed);
     }
 
-    // remove a specific item from cache - O(1) average case
-    bool remove(const std::string &key)
+    Totals totals() const
     {
-        std::unique_lock<std::shared_mutex> lock(mutex);
-        auto it = cache.find(key);
-        if (it != cache.end())
+        Totals totals;
+        std::lock_guard<std::mutex> lock(cellsMutex);
+        for (const Cell &cell : cells)
         {
-            currentSize -= it->second.data.size();
-            lruList.erase(it->second.lruIterator);
-            cache.erase(it);
-            return true;
+            totals.connections += cell.connections.load(std::memory_order_relaxed);
+            totals.bytesReceived += cell.bytesReceived.load(std::memory_order_relaxed);
+            totals.bytesSent += cell.bytesSent.load(std::memory_order_relaxed);
         }
-        return false;
+        return totals;
     }
 
-    // check if an item exists in cache - O(1) average case
-    bool exists(const std::string &key)
+private:
+    struct alignas(64) Cell
     {
-        std::shared_lock<std::shared_mutex> lock(mutex);
-        return cache.find(key) != cache.end();
-    }
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> bytesReceived{0};
+        std::atomic<uint64_t> bytesSent{0};
+    };
 
-    // get current size of cache in bytes - O(1)
-    size_t size() const
-    {
-        std::shared_lock<std::shared_mutex> lock(mutex);
-        return currentSize;
-    }
+    mutable std::mutex cellsMutex; // taken when a thread first counts and when totals are summed
+    std::deque<Cell> cells;        // deque keeps handed out cells in place
 
-    // get number of items in cache - O(1)
-    size_t count() const
+    Cell &local()
     {
-        std::shared_lock<std::shared_mutex> lock(mutex);
-        return cache.size();
+        thread_local const TrafficCounters *owner = nullptr;
+        thread_local Cell *cell = nullptr;
+        if (owner != this)
+        {
+            std::lock_guard<std::mutex> lock(cellsMutex);
+            cell = &cells.emplace_back();
+            owner = this;
+        }
+        return *cell;
     }
+};
+
+// lowest log level compiled in, 0 debug, 1 info, 2 success, 3 warning, 4 error; the LOG_* macros
+// below this level expand to nothing, so their messages are never even built
+#ifndef PGS_LOG_MIN_LEVEL
+#define PGS_LOG_MIN_LEVEL 0
+#endif
+
+class Logger
+{
+public:
+    enum class Level : uint8_t
+    {
+        Debug,
+        Info,
+        Success,
+        Warning,
+        Error
+    };
+
+private:
+    static Logger *instance;
+    static constexpr auto EVENT_WAIT_LOG_INTERVAL = std::chrono::seconds(5); // log interval for waiting events
+    std::atomic<bool> isWaitingForEvents{false};                              // flag to track event waiting state
+    std::atomic<int64_t> lastEventWaitLog{0};                                 // steady clock ticks of last event wait log
+
+    // fixed-size binary log record, the caller only copies bytes into it; a message longer than
+    // one record's text continues in the records right after it
+    struct alignas(64) LogRecord
+    {
+        static constexpr size_t IP_BYTES = 46; // INET6_ADDRSTRLEN
+        static constexpr size_t TEXT_BYTES = 192;
+
+        int64_t timestamp;      // system clock, nanoseconds since epoch
+        uint32_t length;        // message bytes, over all records of the message
+        uint16_t continuations; // records that follow with the rest of the text
+        Level level;
+        uint8_t ipLength;
+        char ip[IP_BYTES];
+        char text[TEXT_BYTES];
+    };
+    static_assert(sizeof(LogRecord) == 256, "log records are four cache lines");
+
+    // single-producer single-consumer ring of records, one per logging thread
+    struct LogRing
+    {
+        static constexpr uint64_t CAPACITY = 1024; // records, power of two
+
+        std::unique_ptr<LogRecord[]> records{new LogRecord[CAPACITY]};
+        alignas(64) std::atomic<uint64_t> head{0}; // next record the producer writes
+        alignas(64) std::atomic<uint64_t> tail{0}; // next record the consumer reads
+        std::atomic<bool> abandoned{false};        // producer thread has exited
+    };
+
+    // the calling thread's ring, marked abandoned when the thread exits so the consumer can drop it once drained
+    struct Producer
+    {
+        const Logger *owner = nullptr;
+        std::shared_ptr<LogRing> ring;
+
+        ~Producer()
+        {
+            if (ring)
+            {
+                ring->abandoned.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    std::mutex ringsMutex;                     // guards rings, taken when a thread logs for the first time
+    std::vector<std::shared_ptr<LogRing>> rings; // every producer ring, drained by the logger thread
+    std::atomic<uint64_t> ringsVersion{0};     // bumped when rings changes, the logger thread refreshes its copy
+
+    std::mutex wakeMutex;            // pairs with wakeCV
+    std::condition_variable wakeCV;  // wakes the logger thread before its poll interval
+    bool wakeRequested = false;      // set under wakeMutex
+    std::thread loggerThread;        // background thread formatting and writing records
+    std::atomic<bool> running{true}; // flag to control background thread
+    std::atomic<Level> minLevel{Level::Info}; // runtime level, messages below it are dropped by the caller
+
+    // where formatted lines go, swapped by configure() while the logger thread is between batches
+    struct Sinks
+    {
+        int fileFd = -1;         // log file opened for appending, -1 when disabled
+        bool console = true;     // colored lines on stdout
+        int syslogFd = -1;       // datagram socket of a syslog daemon, -1 when disabled
+        std::string syslogPath;  // socket path, reconnected when the daemon restarts
+    };
+    std::mutex sinksMutex; // held by the logger thread for a whole batch
+    Sinks sinks;
+
+    static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(10); // idle wait between drains
+    static constexpr size_t FLUSH_BYTES = 256 * 1024;                     // output buffered before a write
+
+    Logger()
+    {
+        sinks.fileFd = ::open("pgs.log", O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644); // default until configure()
+        // start background logging thread
+        loggerThread = std::thread(&Logger::processLogs, this);
+        log("Logger initialized", Level::Success);
+    }
+
+    LogRing &localRing()
+    {
+        thread_local Producer producer;
+        if (producer.owner != this)
+        {
+            auto ring = std::make_shared<LogRing>();
+            {
+                std::lock_guard<std::mutex> lock(ringsMutex);
+                rings.push_back(ring);
+            }
+            ringsVersion.fetch_add(1, std::memory_order_release);
+            if (producer.ring)
+            {
+                producer.ring->abandoned.store(true, std::memory_order_release); // ring of a destroyed logger
+            }
+            producer.ring = std::move(ring);
+            producer.owner = this;
+        }
+        return *producer.ring;
+    }
+
+    void wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            wakeRequested = true;
+        }
+        wakeCV.notify_one();
+    }
+
+    // copy one message into the calling thread's ring, waits for the logger thread when the ring is full
+    void push(std::string_view message, Level level, std::string_view ip)
+    {
+        LogRing &ring = localRing();
+        const size_t maxLength = (LogRing::CAPACITY / 2) * LogRecord::TEXT_BYTES;
+        message = message.substr(0, maxLength);
+        const uint64_t count = message.size() <= LogRecord::TEXT_BYTES
+                                   ? 1
+                                   : (message.size() + LogRecord::TEXT_BYTES - 1) / LogRecord::TEXT_BYTES;
+
+        const uint64_t head = ring.head.load(std::memory_order_relaxed);
+        while (head + count - ring.tail.load(std::memory_order_acquire) > LogRing::CAPACITY)
+        {
+            wake(); // never drop a message, back off until the logger thread catches up
+            std::this_thread::yield();
+        }
+
+        LogRecord &first = ring.records[head & (LogRing::CAPACITY - 1)];
+        first.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+        first.length = static_cast<uint32_t>(message.size());
+        first.continuations = static_cast<uint16_t>(count - 1);
+        first.level = level;
+        first.ipLength = static_cast<uint8_t>(std::min(ip.size(), LogRecord::IP_BYTES));
+        memcpy(first.ip, ip.data(), first.ipLength);
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            const size_t offset = i * LogRecord::TEXT_BYTES;
+            const size_t length = std::min(LogRecord::TEXT_BYTES, message.size() - offset);
+            memcpy(ring.records[(head + i) & (LogRing::CAPACITY - 1)].text, message.data() + offset, length);
+        }
+        ring.head.store(head + count, std::memory_order_release);
+
+        // an idle logger thread polls anyway, wake it early only when the ring fills up
+        if (head + count - ring.tail.load(std::memory_order_relaxed) >= LogRing::CAPACITY / 2)
+        {
+            wake();
+        }
+    }
+
+    // process logs in background thread
+    void processLogs()
+    {
+        std::vector<std::shared_ptr<LogRing>> local; // this thread's copy of rings
+        uint64_t version = ~uint64_t(0);
+        std::string fileBuffer;    // formatted lines for pgs.log
+        std::string consoleBuffer; // the same lines with terminal colors
+        std::string message;       // reassembled text of a multi-record message
+        std::string datagram;      // one syslog message
+        TimestampCache clock{"[%Y-%m-%d %H:%M:%S]"};
+        TimestampCache syslogClock{"%b %e %H:%M:%S"};
+        std::vector<Cursor> cursors; // read position of every ring in the current pass
+        fileBuffer.reserve(FLUSH_BYTES * 2);
+        consoleBuffer.reserve(FLUSH_BYTES * 2);
+
+        while (true)
+        {
+            const bool stopping = !running.load(std::memory_order_acquire);
+            if (ringsVersion.load(std::memory_order_acquire) != version)
+            {
+                std::lock_guard<std::mutex> lock(ringsMutex);
+                version = ringsVersion.load(std::memory_order_relaxed);
+                local = rings;
+            }
+
+            // snapshot what every ring holds right now; read abandoned first, a producer
+            // that exited afterwards may still have left records
+            bool pruned = false;
+            cursors.clear();
+            for (const std::shared_ptr<LogRing> &ring : local)
+            {
+                pruned |= ring->abandoned.load(std::memory_order_acquire);
+                cursors.push_back({ring.get(), ring->tail.load(std::memory_order_relaxed),
+                                   ring->head.load(std::memory_order_acquire)});
+            }
+
+            // merge the rings by timestamp so lines of different threads come out in order
+            std::unique_lock<std::mutex> sinksLock(sinksMutex);
+            const bool formatted = sinks.fileFd != -1 || sinks.console;
+            size_t drained = 0;
+            while (true)
+            {
+                Cursor *next = nullptr;
+                for (Cursor &cursor : cursors)
+                {
+                    if (cursor.tail != cursor.head &&
+                        (!next || cursor.record().timestamp < next->record().timestamp))
+                    {
+                        next = &cursor;
+                    }
+                }
+                if (!next)
+                {
+                    break;
+                }
+
+                const LogRecord &record = next->record();
+                std::string_view text(record.text, std::min<size_t>(record.length, LogRecord::TEXT_BYTES));
+                if (record.continuations > 0)
+                {
+                    message.clear();
+                    for (uint64_t i = 0; i <= record.continuations; ++i)
+                    {
+                        const size_t length = std::min<size_t>(LogRecord::TEXT_BYTES, record.length - message.size());
+                        message.append(next->ring->records[(next->tail + i) & (LogRing::CAPACITY - 1)].text, length);
+                    }
+                    text = message;
+                }
+                if (formatted)
+                {
+                    formatRecord(record, text, clock, sinks.console, fileBuffer, consoleBuffer);
+                }
+                if (sinks.syslogFd != -1)
+                {
+                    sendSyslog(record, text, syslogClock, datagram);
+                }
+                next->tail += 1 + record.continuations;
+                next->ring->tail.store(next->tail, std::memory_order_release); // hand the records back to the producer
+                ++drained;
+
+                if (fileBuffer.size() >= FLUSH_BYTES)
+                {
+                    flush(fileBuffer, consoleBuffer);
+                }
+            }
+            flush(fileBuffer, consoleBuffer);
+            sinksLock.unlock();
+
+            if (pruned)
+            {
+                // forget rings whose thread is gone and which were empty when last looked at
+                std::lock_guard<std::mutex> lock(ringsMutex);
+                std::erase_if(rings, [](const std::shared_ptr<LogRing> &ring)
+                              { return ring->abandoned.load(std::memory_order_acquire) &&
+                                       ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire); });
+                version = ringsVersion.fetch_add(1, std::memory_order_acq_rel) + 1;
+                local = rings;
+            }
+
+            if (stopping)
+            {
+                if (drained == 0)
+                {
+                    return; // every ring empty after shutdown was requested
+                }
+                continue;
+            }
+            if (drained == 0)
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeCV.wait_for(lock, POLL_INTERVAL, [this]
+                                { return wakeRequested || !running.load(std::memory_order_acquire); });
+                wakeRequested = false;
+            }
+        }
+    }
+
+    // records of one ring taken in the current drain pass
+    struct Cursor
+    {
+        LogRing *ring;
+        uint64_t tail;
+        uint64_t head;
+
+        const LogRecord &record() const { return ring->records[tail & (LogRing::CAPACITY - 1)]; }
+    };
+
+    // local time of the current second in a strftime pattern, localtime only runs when the second changes
+    struct TimestampCache
+    {
+        const char *pattern;
+        time_t second = -1;
+        char text[32] = {};
+        size_t length = 0;
+
+        std::string_view format(time_t now)
+        {
+            if (now != second)
+            {
+                struct tm local;
+                localtime_r(&now, &local);
+                length = std::strftime(text, sizeof(text), pattern, &local);
+                second = now;
+            }
+            return std::string_view(text, length);
+        }
+    };
+
+    static const char *levelName(Level level)
+    {
+        switch (level)
+        {
+        case Level::Debug:
+            return "DEBUG";
+        case Level::Success:
+            return "SUCCESS";
+        case Level::Warning:
+            return "WARNING";
+        case Level::Error:
+            return "ERROR";
+        default:
+            return "INFO";
+        }
+    }
+
+    // format timestamp and log message, once for the file and, for the console, once with terminal colors
+    static void formatRecord(const LogRecord &record, std::string_view text, TimestampCache &clock, bool console,
+                             std::string &fileBuffer, std::string &consoleBuffer)
+    {
+        const time_t seconds = static_cast<time_t>(record.timestamp / 1000000000);
+        const int ms = static_cast<int>((record.timestamp / 1000000) % 1000);
+        char millis[8];
+        snprintf(millis, sizeof(millis), ".%03d", ms);
+
+        const size_t start = fileBuffer.size();
+        fileBuffer.append(clock.format(seconds))
+            .append(millis)
+            .append(" [")
+            .append(levelName(record.level))
+            .append("] [")
+            .append(record.ip, record.ipLength)
+            .append("] ")
+            .append(text);
+        const std::string_view line(fileBuffer.data() + start, fileBuffer.size() - start);
+        if (!console)
+        {
+            fileBuffer.push_back('\n');
+            return;
+        }
+
+        // output to console with appropriate color
+        switch (record.level)
+        {
+        case Level::Error:
+            consoleBuffer.append(TerminalUtils::COLORS[2]).append(TerminalUtils::CROSS_MARK);
+            break;
+        case Level::Warning:
+            consoleBuffer.append(TerminalUtils::COLORS[4]).append(TerminalUtils::WARN_MARK);
+            break;
+        case Level::Success:
+            consoleBuffer.append(TerminalUtils::COLORS[3]).append(TerminalUtils::CHECK_MARK);
+            break;
+        case Level::Debug:
+            consoleBuffer.append(TerminalUtils::COLORS[8]).append(TerminalUtils::INFO_MARK);
+            break;
+        default:
+            consoleBuffer.append(TerminalUtils::COLORS[5]).append(TerminalUtils::INFO_MARK);
+            break;
+        }
+        consoleBuffer.append(" ").append(line).append(TerminalUtils::COLORS[0]).append("\n");
+        fileBuffer.push_back('\n');
+    }
+
+    static void writeAll(int fd, const std::string &buffer)
+    {
+        size_t written = 0;
+        while (fd != -1 && written < buffer.size())
+        {
+            ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return; // nowhere left to report a failing log sink
+            }
+            written += static_cast<size_t>(n);
+        }
+    }
+
+    // caller holds sinksMutex
+    void flush(std::string &fileBuffer, std::string &consoleBuffer)
+    {
+        writeAll(sinks.fileFd, fileBuffer);
+        if (sinks.console)
+        {
+            writeAll(STDOUT_FILENO, consoleBuffer);
+        }
+        fileBuffer.clear();
+        consoleBuffer.clear();
+    }
+
+    // unix datagram socket connected to a syslog daemon, -1 when it cannot be reached
+    static int connectSyslog(const std::string &path)
+    {
+        struct sockaddr_un address{};
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        address.sun_family = AF_UNIX;
+        memcpy(address.sun_path, path.data(), path.size());
+        int fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd != -1 && ::connect(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+
+    // one RFC 3164 message per record, facility daemon; a daemon that cannot keep up loses messages
+    // instead of stalling the file and console sinks; caller holds sinksMutex
+    void sendSyslog(const LogRecord &record, std::string_view text, TimestampCache &clock, std::string &datagram)
+    {
+        static const int SEVERITY[] = {7, 6, 5, 4, 3}; // debug, info, notice, warning, err by Level
+        const int priority = 3 * 8 + SEVERITY[static_cast<int>(record.level)];
+        datagram.assign("<").append(std::to_string(priority)).append(">");
+        datagram.append(clock.format(static_cast<time_t>(record.timestamp / 1000000000)))
+            .append(" pgs[")
+            .append(std::to_string(::getpid()))
+            .append("]: [")
+            .append(record.ip, record.ipLength)
+            .append("] ")
+            .append(text);
+
+        if (::send(sinks.syslogFd, datagram.data(), datagram.size(), MSG_DONTWAIT | MSG_NOSIGNAL) == -1 &&
+            (errno == ECONNREFUSED || errno == ENOTCONN))
+        {
+            int fd = connectSyslog(sinks.syslogPath); // the daemon restarted, its socket was recreated
+            if (fd != -1)
+            {
+                ::close(sinks.syslogFd);
+                sinks.syslogFd = fd;
+                ::send(fd, datagram.data(), datagram.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            }
+        }
+    }
+
+public:
+    // singleton pattern implementation
+    static Logger *getInstance()
+    {
+        if (instance == nullptr)
+        {
+            instance = new Logger();
+        }
+        return instance;
+    }
+
+    static void destroyInstance() // clean up
+    {
+        delete instance;
+        instance = nullptr;
+    }
+
+    // ensure proper cleanup in destructor, everything logged so far is written first
+    ~Logger()
+    {
+        running = false; // signal background thread to stop
+        wake();          // wake up background thread
+
+        if (loggerThread.joinable())
+        {
+            loggerThread.join(); // wait for background thread to finish
+        }
+
+        if (sinks.fileFd != -1)
+        {
+            ::close(sinks.fileFd);
+        }
+        if (sinks.syslogFd != -1)
+        {
+            ::close(sinks.syslogFd);
+        }
+    }
+
+    static std::optional<Level> parseLevel(std::string_view name)
+    {
+        static const std::pair<std::string_view, Level> LEVELS[] = {
+            {"debug", Level::Debug}, {"info", Level::Info}, {"success", Level::Success},
+            {"warning", Level::Warning}, {"error", Level::Error}};
+        for (const auto &[levelName, level] : LEVELS)
+        {
+            if (name == levelName)
+            {
+                return level;
+            }
+        }
+        return std::nullopt;
+    }
+
+    static constexpr bool compiledIn(Level level)
+    {
+        return static_cast<int>(level) >= PGS_LOG_MIN_LEVEL;
+    }
+
+    bool enabled(Level level) const
+    {
+        return compiledIn(level) && level >= minLevel.load(std::memory_order_relaxed);
+    }
+
+    // replace the default sinks (pgs.log and the console) and level; an empty file or syslog path
+    // disables that sink, throws when a sink cannot be opened
+    void configure(Level level, const std::string &filePath, bool console, const std::string &syslogPath)
+    {
+        Sinks next;
+        next.console = console;
+        next.syslogPath = syslogPath;
+        if (!filePath.empty())
+        {
+            next.fileFd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (next.fileFd == -1)
+            {
+                throw std::runtime_error("Cannot open log file " + filePath + ": " + strerror(errno));
+            }
+        }
+        if (!syslogPath.empty())
+        {
+            next.syslogFd = connectSyslog(syslogPath);
+            if (next.syslogFd == -1)
+            {
+                const int error = errno;
+                if (next.fileFd != -1)
+                {
+                    ::close(next.fileFd);
+                }
+                throw std::runtime_error("Cannot connect to syslog socket " + syslogPath + ": " + strerror(error));
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(sinksMutex);
+            std::swap(sinks, next);
+        }
+        minLevel.store(level, std::memory_order_relaxed);
+        if (next.fileFd != -1)
+        {
+            ::close(next.fileFd);
+        }
+        if (next.syslogFd != -1)
+        {
+            ::close(next.syslogFd);
+        }
+    }
+
+    // main logging function
+    void log(std::string_view message, Level level = Level::Info, std::string_view ip = "-")
+    {
+        if (!enabled(level))
+        {
+            return;
+        }
+
+        // handle special case for "Waiting for events" messages
+        if (message == "Waiting for events...")
+        {
+            const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+            const int64_t interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(EVENT_WAIT_LOG_INTERVAL).count();
+            if (isWaitingForEvents.exchange(true) && now - lastEventWaitLog.load() < interval)
+            {
+                return; // skip logging if we're already waiting and interval hasn't passed
+            }
+            lastEventWaitLog.store(now);
+        }
+        else if (isWaitingForEvents.load(std::memory_order_relaxed))
+        {
+            isWaitingForEvents.store(false, std::memory_order_relaxed); // reset waiting flag
+        }
+
+        push(message, level, ip); // queue log message for async processing
+    }
+
+    // convenience methods for different log levels, prefer the LOG_* macros which skip building
+    // the message when the level is filtered out
+    void debug(std::string_view message, std::string_view ip = "-")
+    {
+        log(message, Level::Debug, ip);
+    }
+
+    void error(std::string_view message, std::string_view ip = "-")
+    {
+        log(message, Level::Error, ip);
+    }
+
+    void warning(std::string_view message, std::string_view ip = "-")
+    {
+        log(message, Level::Warning, ip);
+    }
+
+    void success(std::string_view message, std::string_view ip = "-")
+    {
+        log(message, Level::Success, ip);
+    }
+
+    void info(std::string_view message, std::string_view ip = "-")
+    {
+        log(message, Level::Info, ip);
+    }
+};
+
+Logger *Logger::instance = nullptr; // initialize static singleton instance
+
+// log through the singleton, the arguments are only evaluated when the level is compiled in and enabled
+#define PGS_LOG_AT(LEVEL, METHOD, ...)                                    \
+    do                                                                    \
+    {                                                                     \
+        if constexpr (Logger::compiledIn(Logger::Level::LEVEL))           \
+        {                                                                 \
+            if (Logger::getInstance()->enabled(Logger::Level::LEVEL))     \
+            {                                                             \
+                Logger::getInstance()->METHOD(__VA_ARGS__);               \
+            }                                                             \
+        }                                                                 \
+    } while (0)
+
+#define LOG_DEBUG(...) PGS_LOG_AT(Debug, debug, __VA_ARGS__)
+#define LOG_INFO(...) PGS_LOG_AT(Info, info, __VA_ARGS__)
+#define LOG_SUCCESS(...) PGS_LOG_AT(Success, success, __VA_ARGS__)
+#define LOG_WARNING(...) PGS_LOG_AT(Warning, warning, __VA_ARGS__)
+#define LOG_ERROR(...) PGS_LOG_AT(Error, error, __VA_ARGS__)
+
+// Immutable bytes of a cached body, held in its own vector or borrowed from a longer lived
+// region (a cache snapshot mapping) that owner keeps alive
+class Buffer
+{
+public:
+    explicit Buffer(std::vector<char> bytes) : storage(std::move(bytes)), bytes(storage.data()), length(storage.size()) {}
+    Buffer(const char *data, size_t size, std::shared_ptr<const void> owner)
+        : owner(std::move(owner)), bytes(data), length(size) {}
+
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+    const char *begin() const { return bytes; }
+    const char *end() const { return bytes + length; }
+
+private:
+    std::vector<char> storage;         // own bytes, empty when borrowed
+    std::shared_ptr<const void> owner; // keeps borrowed bytes mapped
+    const char *bytes;
+    size_t length;
+};
+
+// Immutable, reference counted body shared by the cache and in-flight responses
+// a send holding a reference keeps the memory pinned even if the entry is evicted
+using SharedBuffer = std::shared_ptr<const Buffer>;
+
+// Content codings a cache entry can hold a representation for
+enum class ContentEncoding : uint8_t
+{
+    Identity, // unencoded file content
+    Gzip,     // gzip compressed content
+    Brotli,   // brotli compressed content
+    Zstd,     // zstd compressed content
+    Count     // number of encodings, keep last
+};
+static_assert(static_cast<size_t>(ContentEncoding::Count) == AccessLogFormat::ENCODING_COUNT,
+              "access log encoding names follow ContentEncoding");
+
+// Content-Encoding token for a coding, nullptr for identity
+[[nodiscard]]
+inline const char *contentEncodingToken(ContentEncoding encoding)
+{
+    switch (encoding)
+    {
+    case ContentEncoding::Gzip:
+        return "gzip";
+    case ContentEncoding::Brotli:
+        return "br";
+    case ContentEncoding::Zstd:
+        return "zstd";
+    default:
+        return nullptr;
+    }
+}
+
+class Cache
+{
+private:
+    // Cache entry structure for storing file content and metadata - O(1) access time
+    struct CacheEntry
+    {
+        std::array<SharedBuffer, static_cast<size_t>(ContentEncoding::Count)> variants; // content per encoding, identity always set
+        std::string mimeType;                           // MIME type of cached content
+        time_t lastModified;                            // last modification time of file, all variants belong to it
+        std::chrono::steady_clock::time_point storedAt; // when the identity content was read, for maxAge
+        std::list<std::string>::iterator clockIterator; // iterator pointing to key's position in CLOCK ring
+        mutable std::atomic<bool> referenced{false};    // CLOCK reference bit, set by hits without exclusive lock
+        size_t bytes;                                   // total size of all variants
+        size_t hash;                                    // key hash, for frequency lookups of eviction candidates
+
+        // constructor sharing an existing buffer - O(1), no data copy
+        CacheEntry(SharedBuffer d, const std::string &m, time_t lm,
+                   std::list<std::string>::iterator it, size_t h)
+            : mimeType(m), lastModified(lm), storedAt(std::chrono::steady_clock::now()), clockIterator(it),
+              bytes(d->size()), hash(h)
+        {
+            variants[static_cast<size_t>(ContentEncoding::Identity)] = std::move(d);
+        }
+    };
+
+    // Approximate access counts of recently requested keys, cached or not (count-min sketch, 4 rows of
+    // counters saturating at 15); all counters are halved periodically so old popularity fades
+    class FrequencySketch
+    {
+    public:
+        void init(size_t width)
+        {
+            mask = width - 1; // width is a power of two
+            counters = std::make_unique<std::atomic<uint8_t>[]>(width);
+            sampleSize = width * 10;
+        }
+
+        // racing increments may lose a count, which only makes the estimate a little lower
+        void increment(size_t hash)
+        {
+            for (size_t row = 0; row < DEPTH; ++row)
+            {
+                std::atomic<uint8_t> &counter = counters[index(hash, row)];
+                uint8_t value = counter.load(std::memory_order_relaxed);
+                if (value < MAX_COUNT)
+                {
+                    counter.store(value + 1, std::memory_order_relaxed);
+                }
+            }
+            if (additions.fetch_add(1, std::memory_order_relaxed) + 1 == sampleSize)
+            {
+                age();
+            }
+        }
+
+        [[nodiscard]] uint8_t estimate(size_t hash) const
+        {
+            uint8_t frequency = MAX_COUNT;
+            for (size_t row = 0; row < DEPTH; ++row)
+            {
+                frequency = std::min(frequency, counters[index(hash, row)].load(std::memory_order_relaxed));
+            }
+            return frequency;
+        }
+
+    private:
+        static constexpr size_t DEPTH = 4;
+        static constexpr uint8_t MAX_COUNT = 15;
+        static constexpr uint64_t SEEDS[DEPTH] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full,
+                                                  0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+
+        std::unique_ptr<std::atomic<uint8_t>[]> counters;
+        size_t mask = 0;
+        size_t sampleSize = 0;          // additions between two agings
+        std::atomic<size_t> additions{0};
+
+        [[nodiscard]] size_t index(size_t hash, size_t row) const
+        {
+            uint64_t h = (static_cast<uint64_t>(hash) + row) * SEEDS[row];
+            return static_cast<size_t>(h ^ (h >> 29)) & mask;
+        }
+
+        void age()
+        {
+            for (size_t i = 0; i <= mask; ++i)
+            {
+                counters[i].store(counters[i].load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+            }
+            additions.store(sampleSize / 2, std::memory_order_relaxed);
+        }
+    };
+
+    // Independent slice of the cache with its own lock and byte budget
+    struct Shard
+    {
+        std::unordered_map<std::string, CacheEntry> entries; // shard storage (key -> entry mapping)
+        std::list<std::string> clockRing;                    // CLOCK ring of keys, hand sweeps towards end
+        std::list<std::string>::iterator hand;               // CLOCK hand, next eviction candidate
+        mutable std::shared_mutex mutex;                     // readers share, writers exclusive
+        size_t maxSize = 0;                                  // byte budget of this shard
+        size_t currentSize = 0;                              // bytes held by this shard
+        FrequencySketch sketch;                              // request frequency of keys in this shard
+        std::atomic<uint64_t> hits{0};                       // requests answered from the cache
+        std::atomic<uint64_t> misses{0};                     // requests that had to go to disk
+        std::atomic<uint64_t> admitted{0};                   // entries accepted by set
+        std::atomic<uint64_t> rejected{0};                   // entries turned away to keep more popular ones
+        std::atomic<uint64_t> evicted{0};                    // entries pushed out for new ones
+
+        Shard() : hand(clockRing.end()) {}
+
+        // unlink an entry from ring and map, keeps hand valid - O(1)
+        void erase(std::unordered_map<std::string, CacheEntry>::iterator it)
+        {
+            if (hand == it->second.clockIterator)
+            {
+                ++hand;
+            }
+            currentSize -= it->second.bytes;
+            clockRing.erase(it->second.clockIterator);
+            entries.erase(it);
+        }
+
+        // CLOCK second chance: skip recently referenced entries once, evict the first cold one - amortized O(1)
+        void evictOne()
+        {
+            while (!clockRing.empty())
+            {
+                if (hand == clockRing.end())
+                {
+                    hand = clockRing.begin();
+                }
+                auto it = entries.find(*hand);
+                if (it->second.referenced.exchange(false, std::memory_order_relaxed))
+                {
+                    ++hand;
+                    continue;
+                }
+                erase(it);
+                evicted.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        // size-aware TinyLFU: sweep like evictOne until enough bytes would be freed, then evict all of those
+        // victims, or none of them when one is requested at least as often as the candidate; a large file has
+        // to outrank every entry it would displace - O(victims) amortized
+        bool makeRoom(size_t needed, uint8_t candidateFrequency, bool filter, const std::string *keep = nullptr)
+        {
+            std::vector<std::unordered_map<std::string, CacheEntry>::iterator> victims;
+            size_t freed = 0;
+            auto position = hand;
+            for (size_t steps = 0, limit = 2 * clockRing.size(); freed < needed && steps < limit; ++steps)
+            {
+                if (position == clockRing.end())
+                {
+                    position = clockRing.begin();
+                }
+                auto it = entries.find(*position);
+                ++position;
+                if ((keep && it->first == *keep) || it->second.referenced.exchange(false, std::memory_order_relaxed))
+                {
+                    continue; // second chance, as in evictOne
+                }
+                if (filter && sketch.estimate(it->second.hash) >= candidateFrequency)
+                {
+                    return false;
+                }
+                if (std::find(victims.begin(), victims.end(), it) == victims.end())
+                {
+                    victims.push_back(it);
+                    freed += it->second.bytes;
+                }
+            }
+            if (freed < needed)
+            {
+                return false;
+            }
+
+            hand = position; // before erasing, erase moves the hand off a victim
+            for (auto victim : victims)
+            {
+                erase(victim);
+            }
+            evicted.fetch_add(victims.size(), std::memory_order_relaxed);
+            return true;
+        }
+    };
+
+    static constexpr size_t MAX_SHARDS = 16;                   // upper bound on shard count (power of two)
+    static constexpr size_t MIN_SHARD_BYTES = 8 * 1024 * 1024; // keep shards large enough for big assets
+
+    std::unique_ptr<Shard[]> shards;    // key-hash partitioned shards
+    size_t shardCount;                  // number of shards (power of two)
+    size_t maxSize;                     // maximum size of cache in bytes
+    std::atomic<std::chrono::seconds::rep> maxAge; // maximum age of cache entries in seconds
+    bool admissionFilter;               // TinyLFU admission, otherwise every entry that fits is admitted
+
+    [[nodiscard]] Shard &shardFor(size_t h) const
+    {
+        // mix high bits in, the low bits of std::hash are also used by each shard's map
+        return shards[(h ^ (h >> 17) ^ (h >> 31)) & (shardCount - 1)];
+    }
+
+    [[nodiscard]] Shard &shardFor(const std::string &key) const
+    {
+        return shardFor(std::hash<std::string>{}(key));
+    }
+
+public:
+    // constructor with overflow check - O(shards)
+    explicit Cache(size_t maxSizeMB, std::chrono::seconds maxAge, bool admissionFilter = true)
+        : maxSize(static_cast<size_t>(maxSizeMB) * 1024 * 1024),
+          maxAge(maxAge.count()),
+          admissionFilter(admissionFilter)
+    {
+        // check for cache size overflow
+        if (maxSize / (1024 * 1024) != maxSizeMB) // calculate: 1024*1024=1048576(1MB)
+        {
+            throw std::overflow_error("Cache size overflow");
+        }
+
+        // more shards means less contention, but each one must still hold large files
+        shardCount = 1;
+        while (shardCount < MAX_SHARDS && maxSize / (shardCount * 2) >= MIN_SHARD_BYTES)
+        {
+            shardCount *= 2;
+        }
+        shards = std::make_unique<Shard[]>(shardCount);
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            shards[i].maxSize = maxSize / shardCount;
+            shards[i].sketch.init(std::max<size_t>(1024, std::bit_ceil(shards[i].maxSize / 4096))); // ~ one counter per 4KB
+        }
+    }
+
+    // retrieve an item from cache - O(1) average case, hands out a reference instead of a copy
+    // hits only take the shard's shared lock, recency is recorded in the entry's CLOCK bit;
+    // a request counts once towards frequency and hit ratio: on a hit, or on its identity lookup
+    bool get(const std::string &key, SharedBuffer &data, std::string &mimeType, time_t &lastModified,
+             ContentEncoding encoding = ContentEncoding::Identity)
+    {
+        const size_t hash = std::hash<std::string>{}(key);
+        Shard &shard = shardFor(hash);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        const bool hit = it != shard.entries.end() && it->second.variants[static_cast<size_t>(encoding)] &&
+                         std::chrono::steady_clock::now() - it->second.storedAt <= getMaxAge(); // expired entries are replaced by the next set or purgeExpired
+        if (hit || encoding == ContentEncoding::Identity)
+        {
+            shard.sketch.increment(hash);
+            (hit ? shard.hits : shard.misses).fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!hit)
+        {
+            return false; // cache miss
+        }
+
+        data = it->second.variants[static_cast<size_t>(encoding)];
+        mimeType = it->second.mimeType;
+        lastModified = it->second.lastModified;
+        if (!it->second.referenced.load(std::memory_order_relaxed))
+        {
+            it->second.referenced.store(true, std::memory_order_relaxed); // avoid dirtying the line when already set
+        }
+        return true;
+    }
+
+    // add or update an item in cache - O(n) for data copy
+    template <typename Vector>
+    bool set(const std::string &key, const Vector &data,
+             const std::string &mimeType, time_t lastModified)
+    {
+        return set(key, std::make_shared<const Buffer>(std::vector<char>(data.begin(), data.end())), mimeType, lastModified);
+    }
+
+    // add or update an item in cache - O(1) amortized, false if it was not stored
+    bool set(const std::string &key, SharedBuffer data,
+             const std::string &mimeType, time_t lastModified)
+    {
+        const size_t hash = std::hash<std::string>{}(key);
+        Shard &shard = shardFor(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+        // if entry already exists, remove it first, a new version of a cached file keeps its place
+        auto it = shard.entries.find(key);
+        const bool replacing = it != shard.entries.end();
+        if (replacing)
+        {
+            shard.erase(it);
+        }
+
+        // if new entry is too large, don't cache it
+        const size_t dataSize = data->size();
+        if (dataSize > shard.maxSize)
+        {
+            shard.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // evict cold entries until we have enough space, unless they are more popular than the newcomer
+        // in-flight responses keep their own reference to evicted buffers
+        const bool filter = admissionFilter && !replacing;
+        if (shard.currentSize + dataSize > shard.maxSize &&
+            !shard.makeRoom(shard.currentSize + dataSize - shard.maxSize, shard.sketch.estimate(hash), filter) &&
+            filter)
+        {
+            shard.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        while (!shard.clockRing.empty() && shard.currentSize + dataSize > shard.maxSize)
+        {
+            shard.evictOne();
+        }
+
+        // insert new entry just behind the hand, so it is the last one the hand reaches
+        auto ringIt = shard.clockRing.insert(shard.hand, key);
+        try
+        {
+            shard.entries.try_emplace(key, std::move(data), mimeType, lastModified, ringIt, hash);
+            shard.currentSize += dataSize;
+            shard.admitted.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            shard.clockRing.erase(ringIt); // rollback on failure
+            LOG_ERROR("Cache allocation failed: " + std::string(e.what()));
+            return false;
+        }
+    }
+
+    // attach an encoded representation to an existing entry - O(1) amortized
+    // only accepted for the same file version the identity content was cached for
+    bool setVariant(const std::string &key, ContentEncoding encoding, SharedBuffer data, time_t lastModified)
+    {
+        Shard &shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end() || it->second.lastModified != lastModified ||
+            encoding == ContentEncoding::Identity)
+        {
+            return false;
+        }
+
+        const size_t variantIndex = static_cast<size_t>(encoding);
+        const size_t oldSize = it->second.variants[variantIndex] ? it->second.variants[variantIndex]->size() : 0;
+        const size_t newSize = data->size();
+        if (it->second.bytes - oldSize + newSize > shard.maxSize)
+        {
+            return false;
+        }
+
+        // make room among the other entries, only for a file at least as popular as what it displaces
+        if (shard.currentSize - oldSize + newSize > shard.maxSize &&
+            !shard.makeRoom(shard.currentSize - oldSize + newSize - shard.maxSize, shard.sketch.estimate(it->second.hash),
+                            admissionFilter, &key))
+        {
+            shard.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        it->second.variants[variantIndex] = std::move(data);
+        it->second.bytes = it->second.bytes - oldSize + newSize;
+        shard.currentSize = shard.currentSize - oldSize + newSize;
+        return true;
+    }
+
+    // clear all items from cache - O(n)
+    void clear()
+    {
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            Shard &shard = shards[i];
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.entries.clear();
+            shard.clockRing.clear();
+            shard.hand = shard.clockRing.end();
+            shard.currentSize = 0;
+        }
+    }
+
+    // remove a specific item from cache - O(1) average case
+    bool remove(const std::string &key)
+    {
+        Shard &shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end())
+        {
+            shard.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+    // remove path and every key below it, for a directory that changed as a whole - O(n)
+    size_t removeTree(const std::string &path)
+    {
+        size_t removed = 0;
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            Shard &shard = shards[i];
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            for (auto it = shard.entries.begin(); it != shard.entries.end();)
+            {
+                const std::string &key = it->first;
+                auto next = std::next(it);
+                if (key.compare(0, path.size(), path) == 0 && (key.size() == path.size() || key[path.size()] == '/'))
+                {
+                    shard.erase(it);
+                    ++removed;
+                }
+                it = next;
+            }
+        }
+        return removed;
+    }
+
+    // drop entries older than maxAge so they stop holding memory - O(n)
+    size_t purgeExpired()
+    {
+        const auto cutoff = std::chrono::steady_clock::now() - getMaxAge();
+        size_t removed = 0;
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            Shard &shard = shards[i];
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            for (auto it = shard.entries.begin(); it != shard.entries.end();)
+            {
+                auto next = std::next(it);
+                if (it->second.storedAt < cutoff)
+                {
+                    shard.erase(it);
+                    ++removed;
+                }
+                it = next;
+            }
+        }
+        return removed;
+    }
+
+    // entry contents as seen by forEach, buffers are shared rather than copied
+    struct EntryView
+    {
+        const std::string &key;
+        const std::string &mimeType;
+        time_t lastModified;
+        const std::array<SharedBuffer, static_cast<size_t>(ContentEncoding::Count)> &variants;
+    };
+
+    // visit every unexpired entry, one shard locked (shared) at a time - O(n)
+    template <typename Visitor>
+    void forEach(Visitor &&visit) const
+    {
+        const auto cutoff = std::chrono::steady_clock::now() - getMaxAge();
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+            for (const auto &[key, entry] : shards[i].entries)
+            {
+                if (entry.storedAt >= cutoff)
+                {
+                    visit(EntryView{key, entry.mimeType, entry.lastModified, entry.variants});
+                }
+            }
+        }
+    }
+
+    // check if an item exists in cache - O(1) average case
+    bool exists(const std::string &key)
+    {
+        Shard &shard = shardFor(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.entries.find(key) != shard.entries.end();
+    }
+
+    // get current size of cache in bytes - O(shards)
+    size_t size() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+            total += shards[i].currentSize;
+        }
+        return total;
+    }
+
+    // get number of items in cache - O(shards)
+    size_t count() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+            total += shards[i].entries.size();
+        }
+        return total;
+    }
+
+    // get maximum age of cache entries - O(1)
+    std::chrono::seconds getMaxAge() const
+    {
+        return std::chrono::seconds(maxAge.load(std::memory_order_relaxed));
+    }
+
+    // set a new maximum age for cache entries - O(1)
+    void setMaxAge(std::chrono::seconds newMaxAge)
+    {
+        maxAge.store(newMaxAge.count(), std::memory_order_relaxed);
+    }
+
+    // structure to hold cache statistics
+    struct CacheStats
+    {
+        size_t currentSize;          // current cache size in bytes
+        size_t maxSize;              // maximum cache size in bytes
+        size_t itemCount;            // number of items in cache
+        size_t shardCount;           // number of independently locked shards
+        std::chrono::seconds maxAge; // maximum age of cache entries
+        uint64_t hits;               // requests served from the cache
+        uint64_t misses;             // requests that went to disk
+        uint64_t admitted;           // entries stored
+        uint64_t rejected;           // entries refused by admission or size
+        uint64_t evicted;            // entries displaced by newer ones
+
+        [[nodiscard]] double hitRatio() const
+        {
+            return hits + misses ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+        }
+    };
+
+    // get cache statistics - O(shards)
+    CacheStats getStats() const
+    {
+        CacheStats stats{size(), maxSize, count(), shardCount, getMaxAge(), 0, 0, 0, 0, 0};
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            stats.hits += shards[i].hits.load(std::memory_order_relaxed);
+            stats.misses += shards[i].misses.load(std::memory_order_relaxed);
+            stats.admitted += shards[i].admitted.load(std::memory_order_relaxed);
+            stats.rejected += shards[i].rejected.load(std::memory_order_relaxed);
+            stats.evicted += shards[i].evicted.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+};
+
+// Append-only file of cache entries (key, MIME type, mtime and every coded variant), mapped on boot so a restart
+// serves its previous working set straight from the page cache without rereading or recompressing anything
+class CacheSnapshot
+{
+public:
+    explicit CacheSnapshot(std::string path) : path(std::move(path)) {}
+
+    // map the snapshot and insert every entry whose file is unchanged on disk, returns the entries restored
+    size_t load(Cache &cache)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return 0; // first run
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MAGIC))
+        {
+            close(fd);
+            return 0;
+        }
+        const size_t length = static_cast<size_t>(st.st_size);
+        void *addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps the file referenced
+        if (addr == MAP_FAILED)
+        {
+            LOG_WARNING("Cannot map cache snapshot " + path + ": " + std::string(strerror(errno)));
+            return 0;
+        }
+        auto mapping = std::make_shared<const Mapping>(addr, length);
+        const char *base = static_cast<const char *>(addr);
+        if (memcmp(base, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            LOG_WARNING("Ignoring cache snapshot with unknown format: " + path);
+            return 0;
+        }
+
+        // replay the log, a later record for a key supersedes earlier ones
+        struct Restored
+        {
+            std::string mimeType;
+            time_t lastModified = 0;
+            std::array<std::pair<const char *, size_t>, static_cast<size_t>(ContentEncoding::Count)> variants{};
+        };
+        std::unordered_map<std::string, Restored> restored;
+        std::vector<std::string> order;
+        size_t offset = sizeof(MAGIC);
+        RecordHeader header;
+        while (offset + sizeof(header) <= length)
+        {
+            memcpy(&header, base + offset, sizeof(header));
+            const size_t keyStart = offset + sizeof(header);
+            const size_t bodyStart = align(keyStart + header.keyLength + header.mimeLength);
+            if (header.magic != RECORD_MAGIC || header.encoding >= static_cast<uint8_t>(ContentEncoding::Count) ||
+                header.bodyLength > length || bodyStart > length || align(bodyStart + header.bodyLength) > length)
+            {
+                break; // torn tail of an interrupted save
+            }
+
+            std::string key(base + keyStart, header.keyLength);
+            auto [it, inserted] = restored.try_emplace(key);
+            Restored &entry = it->second;
+            if (inserted)
+            {
+                order.push_back(key);
+            }
+            if (header.encoding == static_cast<uint8_t>(ContentEncoding::Identity))
+            {
+                if (!inserted && entry.lastModified != header.lastModified)
+                {
+                    entry.variants = {}; // a newer version of the file, earlier variants are stale
+                }
+                entry.mimeType.assign(base + keyStart + header.keyLength, header.mimeLength);
+                entry.lastModified = header.lastModified;
+            }
+            if (entry.lastModified == header.lastModified)
+            {
+                entry.variants[header.encoding] = {base + bodyStart, header.bodyLength};
+            }
+            offset = align(bodyStart + header.bodyLength);
+        }
+        validLength = offset;
+
+        // only unchanged files come back, everything else is read again on demand
+        size_t count = 0;
+        for (const std::string &key : order)
+        {
+            const Restored &entry = restored[key];
+            const auto &identity = entry.variants[static_cast<size_t>(ContentEncoding::Identity)];
+            struct stat file;
+            if (!identity.first || ::stat(key.c_str(), &file) != 0 || !S_ISREG(file.st_mode) ||
+                file.st_mtime != entry.lastModified || static_cast<size_t>(file.st_size) != identity.second)
+            {
+                continue;
+            }
+            if (!cache.set(key, std::make_shared<const Buffer>(identity.first, identity.second, mapping),
+                           entry.mimeType, entry.lastModified))
+            {
+                continue;
+            }
+
+            uint32_t mask = 1u << static_cast<size_t>(ContentEncoding::Identity);
+            liveBytes += identity.second;
+            for (size_t i = static_cast<size_t>(ContentEncoding::Gzip); i < entry.variants.size(); ++i)
+            {
+                const auto &[data, size] = entry.variants[i];
+                if (data && cache.setVariant(key, static_cast<ContentEncoding>(i),
+                                             std::make_shared<const Buffer>(data, size, mapping), entry.lastModified))
+                {
+                    mask |= 1u << i;
+                    liveBytes += size;
+                }
+            }
+            persisted[key] = {entry.lastModified, mask};
+            ++count;
+        }
+
+        LOG_INFO("Restored " + std::to_string(count) + " cache entries (" +
+                 std::to_string(liveBytes / 1024) + "KB) from snapshot " + path);
+        return count;
+    }
+
+    // append entries the file does not hold yet, or rewrite it when it is mostly superseded records
+    void save(const Cache &cache)
+    {
+        struct Pending
+        {
+            std::string key;
+            std::string mimeType;
+            time_t lastModified;
+            ContentEncoding encoding;
+            SharedBuffer body;
+        };
+        std::vector<Pending> all;
+        size_t newBytes = 0;
+        size_t cachedBytes = 0;
+        cache.forEach([&](const Cache::EntryView &entry)
+                      {
+            auto known = persisted.find(entry.key);
+            for (size_t i = 0; i < entry.variants.size(); ++i)
+            {
+                if (!entry.variants[i])
+                {
+                    continue;
+                }
+                const bool stored = known != persisted.end() && known->second.first == entry.lastModified &&
+                                    (known->second.second & (1u << i));
+                all.push_back({entry.key, entry.mimeType, entry.lastModified, static_cast<ContentEncoding>(i),
+                               entry.variants[i]});
+                cachedBytes += entry.variants[i]->size();
+                if (!stored)
+                {
+                    newBytes += entry.variants[i]->size();
+                }
+            } });
+
+        // identity first, a variant record is only accepted behind its identity on load
+        std::stable_sort(all.begin(), all.end(), [](const Pending &a, const Pending &b)
+                         { return a.encoding < b.encoding; });
+
+        // superseded or evicted records past half the file, or a torn tail: start a fresh file
+        const bool compact = validLength == 0 || validLength < fileLength() ||
+                             validLength + newBytes > 2 * cachedBytes + (1 << 20);
+        const std::string target = compact ? path + ".tmp" : path;
+        int fd = ::open(target.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (compact ? O_TRUNC : O_APPEND), 0644);
+        if (fd == -1)
+        {
+            LOG_ERROR("Cannot write cache snapshot " + target + ": " + std::string(strerror(errno)));
+            return;
+        }
+
+        bool ok = !compact || writeAll(fd, MAGIC, sizeof(MAGIC));
+        size_t written = compact ? sizeof(MAGIC) : validLength;
+        size_t records = 0;
+        for (const Pending &record : all)
+        {
+            auto known = persisted.find(record.key);
+            const uint32_t bit = 1u << static_cast<size_t>(record.encoding);
+            if (!compact && known != persisted.end() && known->second.first == record.lastModified &&
+                (known->second.second & bit))
+            {
+                continue;
+            }
+            ok = ok && appendRecord(fd, record.key, record.mimeType, record.lastModified, record.encoding,
+                                    *record.body, written);
+            if (!ok)
+            {
+                break;
+            }
+            ++records;
+        }
+        ok = ok && fdatasync(fd) == 0;
+        close(fd);
+        if (!ok || (compact && rename(target.c_str(), path.c_str()) != 0))
+        {
+            LOG_ERROR("Failed to save cache snapshot " + path + ": " + std::string(strerror(errno)));
+            if (compact)
+            {
+                unlink(target.c_str());
+            }
+            return;
+        }
+
+        // the file now holds exactly what was cached at this point (compacted) or that plus older records
+        if (compact)
+        {
+            persisted.clear();
+        }
+        for (const Pending &record : all)
+        {
+            auto &known = persisted[record.key];
+            if (known.first != record.lastModified)
+            {
+                known = {record.lastModified, 0};
+            }
+            known.second |= 1u << static_cast<size_t>(record.encoding);
+        }
+        validLength = written;
+        LOG_INFO("Saved " + std::to_string(records) + " records to cache snapshot " + path +
+                 (compact ? " (rewritten, " : " (appended, ") + std::to_string(written / 1024) + "KB)");
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'P', 'G', 'S', 'N', 'A', 'P', '0', '1'};
+    static constexpr uint32_t RECORD_MAGIC = 0x52534750; // "PGSR"
+
+    // fixed part of a record, followed by key, MIME type, padding to 8, body and padding to 8
+    struct RecordHeader
+    {
+        uint32_t magic;
+        uint8_t encoding;
+        uint8_t reserved;
+        uint16_t mimeLength;
+        uint32_t keyLength;
+        uint32_t reserved2;
+        int64_t lastModified;
+        uint64_t bodyLength;
+    };
+
+    struct Mapping
+    {
+        void *addr;
+        size_t length;
+        Mapping(void *a, size_t l) : addr(a), length(l) {}
+        ~Mapping() { munmap(addr, length); }
+    };
+
+    std::string path;
+    size_t validLength = 0; // bytes of well-formed records in the file
+    size_t liveBytes = 0;   // body bytes restored into the cache
+    std::unordered_map<std::string, std::pair<time_t, uint32_t>> persisted; // key -> version, encodings in the file
+
+    static size_t align(size_t offset)
+    {
+        return (offset + 7) & ~size_t(7);
+    }
+
+    size_t fileLength() const
+    {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    }
+
+    static bool writeAll(int fd, const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t n = write(fd, data, size);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    static bool appendRecord(int fd, const std::string &key, const std::string &mimeType, time_t lastModified,
+                             ContentEncoding encoding, const Buffer &body, size_t &written)
+    {
+        static constexpr char PADDING[8] = {};
+        RecordHeader header{RECORD_MAGIC, static_cast<uint8_t>(encoding), 0,
+                            static_cast<uint16_t>(std::min<size_t>(mimeType.size(), UINT16_MAX)),
+                            static_cast<uint32_t>(key.size()), 0, static_cast<int64_t>(lastModified), body.size()};
+        const size_t start = written;
+        const size_t bodyStart = align(start + sizeof(header) + header.keyLength + header.mimeLength);
+        const size_t end = align(bodyStart + body.size());
+        const bool ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) &&
+                        writeAll(fd, key.data(), header.keyLength) &&
+                        writeAll(fd, mimeType.data(), header.mimeLength) &&
+                        writeAll(fd, PADDING, bodyStart - (start + sizeof(header) + header.keyLength + header.mimeLength)) &&
+                        writeAll(fd, body.data(), body.size()) &&
+                        writeAll(fd, PADDING, end - (bodyStart + body.size()));
+        written = end;
+        return ok;
+    }
+};
+
+// Structured access log, one fixed 64-byte record per response in the layout of access_log.h. The whole
+// file is mapped shared, so writing a record is a slot reservation and a copy, and whatever was written
+// survives a crash of the process. Files rotate once full: path -> path.1 -> ... -> path.<keep>
+class AccessLog
+{
+public:
+    // one finished response
+    struct Entry
+    {
+        std::chrono::system_clock::time_point start; // request start
+        const struct in6_addr *address;              // client address
+        std::string_view path;                       // request path as sent
+        uint16_t status;                             // status code sent, 0 when no response was produced
+        bool cacheHit;                               // body came from the in-memory cache
+        ContentEncoding encoding;                    // content coding of the body
+        uint64_t bytes;                              // bytes written, headers included
+        uint32_t latencyUs;                          // request start to last byte written
+    };
+
+    AccessLog(std::string path, size_t maxBytes, int keep)
+        : path(std::move(path)), capacity(std::max(maxBytes, size_t(64 * 1024)) & ~(AccessLogFormat::SLOT_SIZE - 1)),
+          keep(keep)
+    {
+        // never overwrite the previous run's log, it becomes the first rotated file
+        if (::access(this->path.c_str(), F_OK) == 0)
+        {
+            shiftFiles();
+        }
+        if (!openFile())
+        {
+            throw std::runtime_error("Cannot open access log " + this->path);
+        }
+        LOG_INFO("Access log " + this->path + ", rotating at " + std::to_string(capacity >> 20) +
+                 "MB, keeping " + std::to_string(keep) + " rotated files");
+    }
+
+    ~AccessLog()
+    {
+        closeFile();
+    }
+
+    AccessLog(const AccessLog &) = delete;
+    AccessLog &operator=(const AccessLog &) = delete;
+
+    void append(const Entry &entry)
+    {
+        while (true)
+        {
+            uint64_t seen;
+            {
+                std::shared_lock<std::shared_mutex> lock(mappingMutex);
+                if (!base)
+                {
+                    return; // disabled after a failed rotation
+                }
+                seen = generation;
+
+                uint32_t pathId;
+                size_t offset;
+                if (internPath(entry.path, pathId) && reserve(1, offset))
+                {
+                    AccessLogFormat::AccessRecord record{};
+                    record.type = AccessLogFormat::Access;
+                    record.cacheHit = entry.cacheHit;
+                    record.encoding = static_cast<uint8_t>(entry.encoding);
+                    record.status = entry.status;
+                    record.pathId = pathId;
+                    record.latencyUs = entry.latencyUs;
+                    record.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                             entry.start.time_since_epoch())
+                                             .count();
+                    record.bytes = entry.bytes;
+                    memcpy(record.address, entry.address, sizeof(record.address));
+                    memcpy(base + offset, &record, sizeof(record));
+                    return;
+                }
+            }
+            rotate(seen); // file full, whoever gets here first starts the next one
+        }
+    }
+
+private:
+    // transparent lookups, so a hit hashes the request's string_view without building a key
+    struct PathHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view path) const { return std::hash<std::string_view>{}(path); }
+    };
 
-    // get maximum age of cache entries - O(1)
-    std::chrono::seconds getMaxAge() const
+    std::string path;
+    const size_t capacity; // file size, a multiple of the slot size
+    const int keep;        // rotated files kept next to the current one
+
+    std::shared_mutex mappingMutex; // writers hold it shared, rotation exclusively
+    uint64_t generation = 0;        // bumped by every rotation, under mappingMutex
+    int fd = -1;
+    char *base = nullptr;
+    std::atomic<size_t> used{0}; // bytes reserved, may run past capacity once the file is full
+
+    std::shared_mutex pathsMutex; // path ids of the current file
+    std::unordered_map<std::string, uint32_t, PathHash, std::equal_to<>> paths;
+
+    bool reserve(size_t slots, size_t &offset)
     {
-        return maxAge; // no lock needed for immutable value
+        const size_t bytes = slots * AccessLogFormat::SLOT_SIZE;
+        offset = used.fetch_add(bytes, std::memory_order_relaxed);
+        return offset + bytes <= capacity;
     }
 
-    // set a new maximum age for cache entries - O(1)
-    void setMaxAge(std::chrono::seconds newMaxAge)
+    // id of a path in the current file, writes its definition the first time; false when the file is full
+    bool internPath(std::string_view requestPath, uint32_t &id)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(pathsMutex);
+            auto it = paths.find(requestPath);
+            if (it != paths.end())
+            {
+                id = it->second;
+                return true;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(pathsMutex);
+        auto it = paths.find(requestPath);
+        if (it != paths.end())
+        {
+            id = it->second;
+            return true;
+        }
+
+        // reserved before the id is published, so every record using it lands behind the definition
+        const std::string_view text = requestPath.substr(0, UINT16_MAX);
+        size_t offset;
+        if (!reserve(AccessLogFormat::pathSlots(text.size()), offset))
+        {
+            return false;
+        }
+        AccessLogFormat::PathRecord record{};
+        record.type = AccessLogFormat::Path;
+        record.length = static_cast<uint16_t>(text.size());
+        record.pathId = static_cast<uint32_t>(paths.size());
+        const size_t head = std::min(text.size(), sizeof(record.text));
+        memcpy(record.text, text.data(), head);
+        memcpy(base + offset, &record, sizeof(record));
+        memcpy(base + offset + sizeof(record), text.data() + head, text.size() - head);
+
+        id = record.pathId;
+        paths.emplace(std::string(requestPath), id);
+        return true;
+    }
+
+    void rotate(uint64_t seen)
+    {
+        std::unique_lock<std::shared_mutex> lock(mappingMutex);
+        if (generation != seen || !base)
+        {
+            return; // another writer already rotated
+        }
+        closeFile();
+        shiftFiles();
+        if (!openFile())
+        {
+            LOG_ERROR("Cannot open access log " + path + ", access logging stopped");
+        }
+        ++generation;
+    }
+
+    // path.<keep-1> -> path.<keep>, ..., path -> path.1; the oldest file is dropped
+    void shiftFiles()
+    {
+        if (keep <= 0)
+        {
+            unlink(path.c_str());
+            return;
+        }
+        for (int i = keep - 1; i >= 1; --i)
+        {
+            rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+        }
+        rename(path.c_str(), (path + ".1").c_str());
+    }
+
+    // a fresh file at full size; blocks are allocated up front, a write to the mapping can't hit a full disk
+    bool openFile()
+    {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1 || posix_fallocate(fd, 0, static_cast<off_t>(capacity)) != 0)
+        {
+            LOG_ERROR("Cannot create access log " + path + ": " + std::string(strerror(errno)));
+            if (fd != -1)
+            {
+                close(fd);
+                fd = -1;
+            }
+            return false;
+        }
+        void *addr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            LOG_ERROR("Cannot map access log " + path + ": " + std::string(strerror(errno)));
+            close(fd);
+            fd = -1;
+            return false;
+        }
+        base = static_cast<char *>(addr);
+
+        AccessLogFormat::FileHeader header{};
+        memcpy(header.magic, AccessLogFormat::MAGIC, sizeof(header.magic));
+        header.version = AccessLogFormat::VERSION;
+        header.slotSize = AccessLogFormat::SLOT_SIZE;
+        header.createdUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+        memcpy(base, &header, sizeof(header));
+        used.store(sizeof(header), std::memory_order_relaxed);
+        paths.clear();
+        return true;
+    }
+
+    // unmap and cut the file to what was written, so readers see no zero tail
+    void closeFile()
+    {
+        if (!base)
+        {
+            return;
+        }
+        const size_t length = std::min(used.load(std::memory_order_relaxed), capacity);
+        munmap(base, capacity);
+        base = nullptr;
+        if (ftruncate(fd, static_cast<off_t>(length)) != 0)
+        {
+            LOG_WARNING("Cannot trim access log " + path + ": " + std::string(strerror(errno)));
+        }
+        close(fd);
+        fd = -1;
+    }
+};
+
+// An open static file with the metadata needed to serve it without touching the path again
+struct OpenFile
+{
+    int fd = -1;           // read-only descriptor, shared by concurrent responses (pread/sendfile use explicit offsets)
+    std::string path;      // resolved and lexically normalized path, index.html appended for directories
+    struct stat st {};     // size, mtime and inode at open time
+    std::string mimeType;  // MIME type of path
+    bool directory = false; // requested path was a directory
+
+    OpenFile() = default;
+    OpenFile(const OpenFile &) = delete;
+    OpenFile &operator=(const OpenFile &) = delete;
+    ~OpenFile()
+    {
+        if (fd != -1)
+            close(fd);
+    }
+};
+
+// Bounded cache of open descriptors and stat results for request paths, so a hot file is served with
+// no path resolution syscalls; absent paths are remembered too, which keeps sidecar probes free
+class FileCache
+{
+public:
+    using MimeResolver = std::string (*)(const std::string &path);
+
+    FileCache(size_t maxEntries, std::chrono::milliseconds revalidateInterval, MimeResolver mimeOf)
+        : maxEntries(std::max<size_t>(maxEntries, 1)), revalidateInterval(revalidateInterval), mimeOf(mimeOf)
+    {
+        LOG_INFO("File cache initialized with " + std::to_string(this->maxEntries) +
+                 " entries, revalidated every " + std::to_string(revalidateInterval.count()) + "ms");
+    }
+
+    // open file for a request path, directories resolve to their index.html; nullptr if there is none
+    [[nodiscard]]
+    std::shared_ptr<const OpenFile> open(const std::string &path)
+    {
+        return lookup(path, true);
+    }
+
+    // open an exact regular file (sidecars), nullptr if there is none
+    [[nodiscard]]
+    std::shared_ptr<const OpenFile> openExact(const std::string &path)
+    {
+        return lookup(path, false);
+    }
+
+    // forget every entry resolving to path (or below it, for a tree), the next lookup resolves it again;
+    // entries are keyed by request path, so this is a scan bounded by maxEntries
+    size_t invalidate(const std::string &path, bool tree = false)
     {
         std::unique_lock<std::shared_mutex> lock(mutex);
-        maxAge = newMaxAge;
+        generation.fetch_add(1, std::memory_order_relaxed);
+        size_t removed = 0;
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            const std::string &resolved = it->second.resolved;
+            const bool match = resolved == path ||
+                               (tree && resolved.size() > path.size() && resolved.compare(0, path.size(), path) == 0 &&
+                                resolved[path.size()] == '/');
+            auto next = std::next(it);
+            if (match)
+            {
+                erase(it);
+                ++removed;
+            }
+            it = next;
+        }
+        return removed;
     }
 
-    // structure to hold cache statistics
-    struct CacheStats
+    // the form paths are resolved to, shared with anything that has to match them (Cache keys, FileWatcher)
+    [[nodiscard]]
+    static std::string normalize(const std::string &path)
     {
-        size_t currentSize;          // current cache size in bytes
-        size_t maxSize;              // maximum cache size in bytes
-        size_t itemCount;            // number of items in cache
-        std::chrono::seconds maxAge; // maximum age of cache entries
+        std::string normal = fs::path(path).lexically_normal().string();
+        while (normal.size() > 1 && normal.back() == '/')
+        {
+            normal.pop_back();
+        }
+        return normal;
+    }
+
+    void clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        entries.clear();
+        clockRing.clear();
+        hand = clockRing.end();
+    }
+
+    [[nodiscard]]
+    size_t count() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return entries.size();
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const OpenFile> file;            // nullptr: path known to be absent
+        std::string resolved;                            // normalized path the request maps to, present or not
+        std::atomic<int64_t> validatedAt;                // steady_clock ticks of the last stat
+        std::list<std::string>::iterator clockIterator;  // position in CLOCK ring
+        mutable std::atomic<bool> referenced{false};     // CLOCK reference bit
+
+        Entry(std::shared_ptr<const OpenFile> f, std::string r, int64_t validated, std::list<std::string>::iterator it)
+            : file(std::move(f)), resolved(std::move(r)), validatedAt(validated), clockIterator(it) {}
     };
 
-    // get cache statistics - O(1)
-    CacheStats getStats() const
-    {
-        std::shared_lock<std::shared_mutex> lock(mutex);
-        return {currentSize, maxSize, cache.size(), maxAge};
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> clockRing;
+    std::list<std::string>::iterator hand = clockRing.end();
+    mutable std::shared_mutex mutex;
+    std::atomic<uint64_t> generation{0}; // bumped by invalidate, lookups racing it store their result as unvalidated
+    size_t maxEntries;
+    std::chrono::milliseconds revalidateInterval;
+    MimeResolver mimeOf;
+
+    [[nodiscard]]
+    static int64_t now()
+    {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    [[nodiscard]]
+    static bool sameFile(const struct stat &a, const struct stat &b)
+    {
+        return a.st_ino == b.st_ino && a.st_dev == b.st_dev && a.st_size == b.st_size &&
+               a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+    }
+
+    std::shared_ptr<const OpenFile> lookup(const std::string &path, bool resolveDirectory)
+    {
+        const int64_t start = now();
+        const int64_t interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(revalidateInterval).count();
+        std::shared_ptr<const OpenFile> cached;
+        bool known = false;
+        const uint64_t observed = generation.load(std::memory_order_relaxed);
+
+        // fresh entry: shared lock only, no syscalls
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = entries.find(path);
+            if (it != entries.end())
+            {
+                it->second.referenced.store(true, std::memory_order_relaxed);
+                if (start - it->second.validatedAt.load(std::memory_order_relaxed) < interval)
+                {
+                    return it->second.file;
+                }
+                cached = it->second.file;
+                known = true;
+            }
+        }
+
+        // resolve the path again, outside of the lock
+        std::string resolved = normalize(path);
+        bool directory = false;
+        struct stat st;
+        bool exists = ::stat(resolved.c_str(), &st) == 0;
+        if (exists && S_ISDIR(st.st_mode) && resolveDirectory)
+        {
+            resolved += "/index.html";
+            directory = true;
+            exists = ::stat(resolved.c_str(), &st) == 0;
+        }
+        exists = exists && S_ISREG(st.st_mode);
+
+        // unchanged since the last check, only the timestamp moves
+        if (known && ((!exists && !cached) || (exists && cached && cached->path == resolved && sameFile(cached->st, st))))
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = entries.find(path);
+            if (it != entries.end() && it->second.file == cached && generation.load(std::memory_order_relaxed) == observed)
+            {
+                it->second.validatedAt.store(start, std::memory_order_relaxed);
+            }
+            return cached;
+        }
+
+        std::shared_ptr<OpenFile> file;
+        if (exists)
+        {
+            int fd = ::open(resolved.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd != -1)
+            {
+                file = std::make_shared<OpenFile>();
+                file->fd = fd;
+                file->path = resolved;
+                file->directory = directory;
+                file->mimeType = mimeOf(resolved);
+                if (fstat(fd, &file->st) != 0)
+                {
+                    file.reset();
+                }
+                else
+                {
+                    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                }
+            }
+        }
+
+        insert(path, file, std::move(resolved), start, observed);
+        return file;
+    }
+
+    void insert(const std::string &path, std::shared_ptr<const OpenFile> file, std::string resolved, int64_t validated,
+                uint64_t observed)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (generation.load(std::memory_order_relaxed) != observed)
+        {
+            validated = 0; // the stat may predate an invalidation, check again on next use
+        }
+        auto it = entries.find(path);
+        if (it != entries.end())
+        {
+            it->second.file = std::move(file);
+            it->second.resolved = std::move(resolved);
+            it->second.validatedAt.store(validated, std::memory_order_relaxed);
+            return;
+        }
+
+        while (entries.size() >= maxEntries)
+        {
+            evictOne();
+        }
+        clockRing.push_back(path);
+        entries.try_emplace(path, std::move(file), std::move(resolved), validated, std::prev(clockRing.end()));
+    }
+
+    // unlink an entry from ring and map, keeps hand valid
+    void erase(std::unordered_map<std::string, Entry>::iterator it)
+    {
+        if (hand == it->second.clockIterator)
+        {
+            ++hand;
+        }
+        clockRing.erase(it->second.clockIterator);
+        entries.erase(it); // descriptor closes once the last response using it lets go
+    }
+
+    // CLOCK second chance, same policy as Cache
+    void evictOne()
+    {
+        while (!clockRing.empty())
+        {
+            if (hand == clockRing.end())
+            {
+                hand = clockRing.begin();
+            }
+            auto it = entries.find(*hand);
+            if (it->second.referenced.exchange(false, std::memory_order_relaxed))
+            {
+                ++hand;
+                continue;
+            }
+            erase(it);
+            return;
+        }
+    }
+};
+
+// Recursive inotify watch of the static folder, reports changed paths so cached copies can be dropped
+class FileWatcher
+{
+public:
+    // path is normalized like FileCache::normalize, tree means everything below it changed too
+    using ChangeHandler = std::function<void(const std::string &path, bool tree)>;
+
+    explicit FileWatcher(const std::string &root) : root(FileCache::normalize(root)),
+                                                    fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    {
+        if (fd == -1)
+        {
+            LOG_WARNING("inotify unavailable, cached files only expire: " + std::string(strerror(errno)));
+            return;
+        }
+        watchTree(this->root);
+        LOG_INFO("Watching " + std::to_string(directories.size()) + " directories under " + this->root);
+    }
+
+    ~FileWatcher()
+    {
+        if (fd != -1)
+            close(fd);
+    }
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    [[nodiscard]]
+    bool active() const
+    {
+        return fd != -1;
+    }
+
+    // wait up to timeoutMs for changes and report each distinct path once per batch
+    void poll(int timeoutMs, const ChangeHandler &onChange)
+    {
+        if (fd == -1)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            return;
+        }
+
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (::poll(&pfd, 1, timeoutMs) <= 0)
+        {
+            return;
+        }
+
+        // a deploy writes a file in many pieces, coalesce them before touching the caches
+        std::unordered_map<std::string, bool> changed; // path -> tree
+        alignas(struct inotify_event) char buffer[16384];
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char *p = buffer; p < buffer + length;)
+            {
+                const auto *event = reinterpret_cast<const struct inotify_event *>(p);
+                p += sizeof(struct inotify_event) + event->len;
+                handleEvent(*event, changed);
+            }
+        }
+
+        for (const auto &[path, tree] : changed)
+        {
+            onChange(path, tree);
+        }
+    }
+
+private:
+    static constexpr uint32_t EVENTS = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                                       IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+    std::string root;                                  // normalized static folder
+    int fd;                                            // inotify instance
+    std::unordered_map<int, std::string> directories; // watch descriptor -> directory path
+
+    // watch a directory and everything below it, re-adding an existing watch just updates its path
+    void watchTree(const std::string &directory)
+    {
+        addWatch(directory);
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(directory, fs::directory_options::skip_permission_denied, ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+        {
+            if (it->is_directory(ec) && !it->is_symlink(ec))
+            {
+                addWatch(FileCache::normalize(it->path().string()));
+            }
+        }
+    }
+
+    void addWatch(const std::string &directory)
+    {
+        int wd = inotify_add_watch(fd, directory.c_str(), EVENTS | IN_ONLYDIR | IN_DONT_FOLLOW);
+        if (wd == -1)
+        {
+            // ENOSPC: fs.inotify.max_user_watches reached, those files fall back to revalidation and maxAge
+            LOG_WARNING("Cannot watch " + directory + ": " + std::string(strerror(errno)));
+            return;
+        }
+        directories[wd] = directory;
+    }
+
+    // stop watching a directory that left the tree, events for it would carry a stale path
+    void unwatchTree(const std::string &directory)
+    {
+        for (auto it = directories.begin(); it != directories.end();)
+        {
+            const std::string &path = it->second;
+            if (path.compare(0, directory.size(), directory) == 0 &&
+                (path.size() == directory.size() || path[directory.size()] == '/'))
+            {
+                inotify_rm_watch(fd, it->first);
+                it = directories.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void handleEvent(const struct inotify_event &event, std::unordered_map<std::string, bool> &changed)
+    {
+        if (event.mask & IN_Q_OVERFLOW)
+        {
+            LOG_WARNING("inotify queue overflow, dropping every cached file");
+            changed[root] = true;
+            return;
+        }
+
+        auto dir = directories.find(event.wd);
+        if (dir == directories.end())
+        {
+            return;
+        }
+        if (event.mask & IN_IGNORED)
+        {
+            directories.erase(dir); // watched directory is gone
+            return;
+        }
+
+        std::string path = dir->second;
+        if (event.len > 0 && event.name[0] != '\0')
+        {
+            path += '/';
+            path += event.name;
+        }
+
+        if (event.mask & IN_ISDIR)
+        {
+            if (event.mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                watchTree(path); // files may have landed before the watch existed
+            }
+            else if (event.mask & IN_MOVED_FROM)
+            {
+                unwatchTree(path);
+            }
+            changed[path] = true;
+            return;
+        }
+
+        if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+        {
+            if (dir->second == root)
+            {
+                LOG_WARNING("Static folder " + root + " was moved or deleted");
+            }
+            changed[dir->second] = true;
+            return;
+        }
+
+        changed.try_emplace(path, false);
     }
 };
 
@@ -493,6 +2907,14 @@ class Middleware
 public:
     virtual ~Middleware() = default;
     virtual std::string process(const std::string &data) = 0;
+
+    // content coding applied by process(), identity for middleware that does not encode bodies
+    [[nodiscard]]
+    virtual ContentEncoding contentEncoding() const { return ContentEncoding::Identity; }
+
+    // client refused identity (identity;q=0), encode even bodies that are normally sent as is
+    [[nodiscard]]
+    virtual bool encodingRequired() const { return false; }
 };
 
 class RateLimiter : public Middleware
@@ -520,7 +2942,7 @@ public:
             // if exceeded, return a 429 Too Many Requests response
             return "HTTP/1.1 429 Too Many Requests\r\n"
                    "Content-Type: text/plain\r\n"
-                   "Content-Length: 19\r\n"
+                   "Content-Length: 17\r\n"
                    "\r\n"
                    "Too Many Requests";
         }
@@ -538,6 +2960,436 @@ private:
     std::mutex rateMutex; // mutex to protect access to clientRequests
 };
 
+// parsed Accept-Encoding header, quality per known coding in thousandths (RFC 9110 section 12.5.3)
+class AcceptEncoding
+{
+public:
+    static constexpr uint16_t MAX_QUALITY = 1000;
+
+    // server preference between codings of equal quality, smallest output first
+    static constexpr ContentEncoding PREFERENCE[] = {ContentEncoding::Brotli, ContentEncoding::Zstd, ContentEncoding::Gzip};
+
+    [[nodiscard]]
+    static AcceptEncoding parse(std::string_view header)
+    {
+        AcceptEncoding result;
+        if (header.empty())
+        {
+            return result; // no header, identity only
+        }
+
+        constexpr size_t count = static_cast<size_t>(ContentEncoding::Count);
+        std::array<int, count> explicitQuality;
+        explicitQuality.fill(-1);
+        int wildcard = -1;
+
+        while (!header.empty())
+        {
+            size_t comma = header.find(',');
+            std::string_view element = header.substr(0, comma);
+            header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+
+            size_t semicolon = element.find(';');
+            std::string_view coding = trim(element.substr(0, semicolon));
+            int quality = MAX_QUALITY;
+            if (semicolon != std::string_view::npos && !parseQuality(element.substr(semicolon + 1), quality))
+            {
+                continue; // malformed weight, ignore the element
+            }
+
+            if (coding == "*")
+            {
+                wildcard = quality;
+            }
+            else if (HttpRequest::equalsIgnoreCase(coding, "gzip") || HttpRequest::equalsIgnoreCase(coding, "x-gzip"))
+            {
+                explicitQuality[static_cast<size_t>(ContentEncoding::Gzip)] = quality;
+            }
+            else if (HttpRequest::equalsIgnoreCase(coding, "br"))
+            {
+                explicitQuality[static_cast<size_t>(ContentEncoding::Brotli)] = quality;
+            }
+            else if (HttpRequest::equalsIgnoreCase(coding, "zstd"))
+            {
+                explicitQuality[static_cast<size_t>(ContentEncoding::Zstd)] = quality;
+            }
+            else if (HttpRequest::equalsIgnoreCase(coding, "identity"))
+            {
+                explicitQuality[static_cast<size_t>(ContentEncoding::Identity)] = quality;
+            }
+        }
+
+        // "*" covers every coding not listed, identity stays acceptable unless refused explicitly or by "*;q=0"
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (explicitQuality[i] >= 0)
+            {
+                result.quality[i] = static_cast<uint16_t>(explicitQuality[i]);
+            }
+            else if (i == static_cast<size_t>(ContentEncoding::Identity))
+            {
+                result.quality[i] = wildcard == 0 ? 0 : MAX_QUALITY;
+            }
+            else
+            {
+                result.quality[i] = static_cast<uint16_t>(std::max(wildcard, 0));
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]]
+    uint16_t qualityOf(ContentEncoding encoding) const
+    {
+        return quality[static_cast<size_t>(encoding)];
+    }
+
+    [[nodiscard]]
+    bool identityAllowed() const
+    {
+        return qualityOf(ContentEncoding::Identity) > 0;
+    }
+
+    // best coding among availableMask (bit per ContentEncoding), identity when the client prefers it
+    [[nodiscard]]
+    ContentEncoding choose(uint32_t availableMask) const
+    {
+        ContentEncoding best = ContentEncoding::Identity;
+        uint16_t bestQuality = 0;
+        for (ContentEncoding encoding : PREFERENCE)
+        {
+            if ((availableMask & (1u << static_cast<unsigned>(encoding))) && qualityOf(encoding) > bestQuality)
+            {
+                best = encoding;
+                bestQuality = qualityOf(encoding);
+            }
+        }
+        return bestQuality >= qualityOf(ContentEncoding::Identity) ? best : ContentEncoding::Identity;
+    }
+
+private:
+    std::array<uint16_t, static_cast<size_t>(ContentEncoding::Count)> quality{MAX_QUALITY}; // identity first, rest refused
+
+    [[nodiscard]]
+    static std::string_view trim(std::string_view value)
+    {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+            value.remove_prefix(1);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+            value.remove_suffix(1);
+        return value;
+    }
+
+    // "q=0.5" style weight, at most three decimals and never above 1
+    [[nodiscard]]
+    static bool parseQuality(std::string_view params, int &quality)
+    {
+        params = trim(params);
+        if (params.size() < 3 || (params[0] != 'q' && params[0] != 'Q') || params[1] != '=')
+        {
+            return false;
+        }
+        std::string_view value = trim(params.substr(2));
+        if (value.empty() || (value[0] != '0' && value[0] != '1'))
+        {
+            return false;
+        }
+
+        int result = (value[0] - '0') * MAX_QUALITY;
+        if (value.size() > 1)
+        {
+            if (value[1] != '.' || value.size() > 5)
+            {
+                return false;
+            }
+            int scale = 100;
+            for (size_t i = 2; i < value.size(); ++i, scale /= 10)
+            {
+                if (value[i] < '0' || value[i] > '9')
+                {
+                    return false;
+                }
+                result += (value[i] - '0') * scale;
+            }
+        }
+        if (result > MAX_QUALITY)
+        {
+            return false;
+        }
+        quality = result;
+        return true;
+    }
+};
+
+// incremental encoder for bodies too large to buffer, one instance per response
+class StreamEncoder
+{
+public:
+    virtual ~StreamEncoder() = default;
+
+    // append the encoding of data to out, finish flushes the trailer, throws std::runtime_error on failure
+    virtual void write(const char *data, size_t size, bool finish, std::string &out) = 0;
+};
+
+// one runtime content coding, implementations are stateless and shared by all workers
+class Encoder
+{
+public:
+    virtual ~Encoder() = default;
+
+    // encode a complete body, throws std::runtime_error on failure
+    [[nodiscard]]
+    virtual std::string encode(const std::string &data) const = 0;
+
+    // fresh streaming state, nullptr when the coding only supports whole bodies
+    [[nodiscard]]
+    virtual std::unique_ptr<StreamEncoder> stream() const { return nullptr; }
+};
+
+class GzipEncoder : public Encoder
+{
+public:
+    explicit GzipEncoder(int level = Z_DEFAULT_COMPRESSION) : level(level) {}
+
+    [[nodiscard]]
+    std::string encode(const std::string &data) const override
+    {
+        z_stream zs;                // create a z_stream object for compression
+        memset(&zs, 0, sizeof(zs)); // zero-initialize z_stream structure
+
+        // Initialize the zlib compression
+        if (deflateInit2(&zs, level,                  // set compression level
+                         Z_DEFLATED,                  // use deflate compression method
+                         15 | 16,                     // 15 | 16 for gzip encoding
+                         8,                           // set window size
+                         Z_DEFAULT_STRATEGY) != Z_OK) // use default compression strategy
+        {
+            throw std::runtime_error("Failed to initialize zlib");
+        }
+
+        // set input data for compression
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data())); // input data
+        zs.avail_in = data.size();
+        // size of input data
+
+        int ret;                         // variable to hold return status of compression
+        const size_t bufferSize = 32768; // define size of output buffer (32KB)
+        std::string compressed;          // string to hold final compressed data
+        char outbuffer[bufferSize];      // buffer for compressed output
+
+        // compress data in a loop until all data is processed
+        do
+        {
+            zs.next_out = reinterpret_cast<Bytef *>(outbuffer); // output buffer for compressed data
+            zs.avail_out = bufferSize;                          // size of output buffer
+
+            ret = deflate(&zs, Z_FINISH); // perform compression operation
+
+            if (compressed.size() < zs.total_out) // append compressed data to output string
+            {
+                compressed.append(outbuffer, zs.total_out - compressed.size());
+            }
+        } while (ret == Z_OK); // continue until no more data to compress
+
+        // check if compression completed successfully
+        if (ret != Z_STREAM_END)
+        {
+            deflateEnd(&zs); // clean up z_stream object
+            throw std::runtime_error("Failed to compress data");
+        }
+
+        deflateEnd(&zs);   // clean up and free resources allocated by zlib
+        return compressed; // return compressed data
+    }
+
+    [[nodiscard]]
+    std::unique_ptr<StreamEncoder> stream() const override
+    {
+        return std::make_unique<Stream>(level);
+    }
+
+private:
+    int level;
+
+    class Stream : public StreamEncoder
+    {
+    public:
+        explicit Stream(int level)
+        {
+            memset(&zs, 0, sizeof(zs));
+            if (deflateInit2(&zs, level, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                throw std::runtime_error("Failed to initialize zlib");
+            }
+        }
+        ~Stream() override { deflateEnd(&zs); }
+
+        void write(const char *data, size_t size, bool finish, std::string &out) override
+        {
+            zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+            zs.avail_in = size;
+
+            char outbuffer[32768];
+            int ret;
+            do
+            {
+                zs.next_out = reinterpret_cast<Bytef *>(outbuffer);
+                zs.avail_out = sizeof(outbuffer);
+                ret = deflate(&zs, finish ? Z_FINISH : Z_NO_FLUSH);
+                if (ret == Z_STREAM_ERROR)
+                {
+                    throw std::runtime_error("Failed to compress data");
+                }
+                out.append(outbuffer, sizeof(outbuffer) - zs.avail_out);
+            } while (zs.avail_out == 0 || (finish && ret != Z_STREAM_END));
+        }
+
+    private:
+        z_stream zs;
+    };
+};
+
+#ifdef PGS_WITH_BROTLI
+class BrotliEncoder : public Encoder
+{
+public:
+    explicit BrotliEncoder(int quality = 5) : quality(quality) {}
+
+    [[nodiscard]]
+    std::string encode(const std::string &data) const override
+    {
+        // one-shot compression into a buffer sized for the worst case
+        size_t encodedSize = BrotliEncoderMaxCompressedSize(data.size());
+        std::string compressed(encodedSize ? encodedSize : data.size() + 1024, '\0');
+        encodedSize = compressed.size();
+        if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                   data.size(), reinterpret_cast<const uint8_t *>(data.data()),
+                                   &encodedSize, reinterpret_cast<uint8_t *>(compressed.data())))
+        {
+            throw std::runtime_error("Failed to compress data with brotli");
+        }
+        compressed.resize(encodedSize);
+        return compressed;
+    }
+
+    [[nodiscard]]
+    std::unique_ptr<StreamEncoder> stream() const override
+    {
+        return std::make_unique<Stream>(quality);
+    }
+
+private:
+    int quality;
+
+    class Stream : public StreamEncoder
+    {
+    public:
+        explicit Stream(int quality) : state(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr))
+        {
+            if (!state)
+            {
+                throw std::runtime_error("Failed to initialize brotli");
+            }
+            BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, static_cast<uint32_t>(quality));
+            BrotliEncoderSetParameter(state, BROTLI_PARAM_MODE, BROTLI_MODE_TEXT);
+        }
+        ~Stream() override { BrotliEncoderDestroyInstance(state); }
+
+        void write(const char *data, size_t size, bool finish, std::string &out) override
+        {
+            const uint8_t *nextIn = reinterpret_cast<const uint8_t *>(data);
+            size_t availIn = size;
+            uint8_t outbuffer[32768];
+            while (true)
+            {
+                uint8_t *nextOut = outbuffer;
+                size_t availOut = sizeof(outbuffer);
+                if (!BrotliEncoderCompressStream(state, finish ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS,
+                                                 &availIn, &nextIn, &availOut, &nextOut, nullptr))
+                {
+                    throw std::runtime_error("Failed to compress data with brotli");
+                }
+                out.append(reinterpret_cast<char *>(outbuffer), sizeof(outbuffer) - availOut);
+                if (availIn == 0 && !BrotliEncoderHasMoreOutput(state) && (!finish || BrotliEncoderIsFinished(state)))
+                {
+                    break;
+                }
+            }
+        }
+
+    private:
+        BrotliEncoderState *state;
+    };
+};
+#endif
+
+#ifdef PGS_WITH_ZSTD
+class ZstdEncoder : public Encoder
+{
+public:
+    explicit ZstdEncoder(int level = 3) : level(level) {}
+
+    [[nodiscard]]
+    std::string encode(const std::string &data) const override
+    {
+        std::string compressed(ZSTD_compressBound(data.size()), '\0');
+        size_t encodedSize = ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), level);
+        if (ZSTD_isError(encodedSize))
+        {
+            throw std::runtime_error(std::string("Failed to compress data with zstd: ") + ZSTD_getErrorName(encodedSize));
+        }
+        compressed.resize(encodedSize);
+        return compressed;
+    }
+
+    [[nodiscard]]
+    std::unique_ptr<StreamEncoder> stream() const override
+    {
+        return std::make_unique<Stream>(level);
+    }
+
+private:
+    int level;
+
+    class Stream : public StreamEncoder
+    {
+    public:
+        explicit Stream(int level) : context(ZSTD_createCCtx())
+        {
+            if (!context)
+            {
+                throw std::runtime_error("Failed to initialize zstd");
+            }
+            ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, level);
+        }
+        ~Stream() override { ZSTD_freeCCtx(context); }
+
+        void write(const char *data, size_t size, bool finish, std::string &out) override
+        {
+            ZSTD_inBuffer input{data, size, 0};
+            char outbuffer[32768];
+            while (true)
+            {
+                ZSTD_outBuffer output{outbuffer, sizeof(outbuffer), 0};
+                size_t remaining = ZSTD_compressStream2(context, &output, &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+                if (ZSTD_isError(remaining))
+                {
+                    throw std::runtime_error(std::string("Failed to compress data with zstd: ") + ZSTD_getErrorName(remaining));
+                }
+                out.append(outbuffer, output.pos);
+                if (finish ? remaining == 0 : input.pos == input.size)
+                {
+                    break;
+                }
+            }
+        }
+
+    private:
+        ZSTD_CCtx *context;
+    };
+};
+#endif
+
 class Compression : public Middleware
 {
 public:
@@ -579,78 +3431,306 @@ public:
         return false; // default case: do not compress
     }
 
+    explicit Compression(ContentEncoding encoding = ContentEncoding::Gzip, bool required = false)
+        : encoding(encoding), required(required) {}
+
+    // replace the registered encoders, call before the server starts serving
+    static void configure(int gzipLevel, int brotliLevel, int zstdLevel)
+    {
+        auto &encoders = registry();
+        encoders[static_cast<size_t>(ContentEncoding::Gzip)] = std::make_unique<GzipEncoder>(gzipLevel);
+#ifdef PGS_WITH_BROTLI
+        encoders[static_cast<size_t>(ContentEncoding::Brotli)] = std::make_unique<BrotliEncoder>(brotliLevel);
+#else
+        (void)brotliLevel;
+#endif
+#ifdef PGS_WITH_ZSTD
+        encoders[static_cast<size_t>(ContentEncoding::Zstd)] = std::make_unique<ZstdEncoder>(zstdLevel);
+#else
+        (void)zstdLevel;
+#endif
+    }
+
+    // plug in an additional or replacement coding, same startup-only rule as configure()
+    static void registerEncoder(ContentEncoding encoding, std::unique_ptr<Encoder> encoder)
+    {
+        if (encoding == ContentEncoding::Identity || encoding == ContentEncoding::Count)
+        {
+            throw std::invalid_argument("Cannot register an encoder for identity");
+        }
+        registry()[static_cast<size_t>(encoding)] = std::move(encoder);
+    }
+
+    // bit per ContentEncoding that has a registered encoder
+    [[nodiscard]]
+    static uint32_t availableEncodings()
+    {
+        uint32_t mask = 0;
+        const auto &encoders = registry();
+        for (size_t i = 0; i < encoders.size(); ++i)
+        {
+            if (encoders[i])
+            {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+    }
+
+    // streaming state for a registered coding, nullptr if unavailable
+    [[nodiscard]]
+    static std::unique_ptr<StreamEncoder> streamEncoder(ContentEncoding encoding)
+    {
+        const Encoder *encoder = registry()[static_cast<size_t>(encoding)].get();
+        return encoder ? encoder->stream() : nullptr;
+    }
+
+    [[nodiscard]]
+    ContentEncoding contentEncoding() const override
+    {
+        return encoding;
+    }
+
     [[nodiscard]]
-    static bool clientAcceptsGzip(const std::string &request)
+    bool encodingRequired() const override
     {
-        return request.find("Accept-Encoding: ") != std::string::npos &&
-               request.find("gzip") != std::string::npos;
+        return required;
     }
 
     [[nodiscard]]
     std::string process(const std::string &data) override
     {
-        std::string compressed = compressData(data);
+        const Encoder *encoder = registry()[static_cast<size_t>(encoding)].get();
+        if (!encoder)
+        {
+            return data; // nothing registered for this coding
+        }
+
+        std::string compressed = encoder->encode(data);
         if (!compressed.empty()) // check if compression was successful
         {
-            Logger::getInstance()->info("Compressed data: " + std::to_string(data.size()) + " -> " + std::to_string(compressed.size()));
+            LOG_DEBUG("Compressed data (" + std::string(contentEncodingToken(encoding)) + "): " +
+                      std::to_string(data.size()) + " -> " + std::to_string(compressed.size()));
             return compressed;
         }
         return data; // Ensure a string is returned in all cases
     }
 
 private:
-    [[nodiscard]]
-    std::string compressData(const std::string &data)
+    ContentEncoding encoding; // coding applied by process()
+    bool required;            // identity refused by the client
+
+    // encoders indexed by ContentEncoding, written only during startup and read-only while serving
+    static std::array<std::unique_ptr<Encoder>, static_cast<size_t>(ContentEncoding::Count)> &registry()
     {
-        z_stream zs;                // create a z_stream object for compression
-        memset(&zs, 0, sizeof(zs)); // zero-initialize z_stream structure
+        static std::array<std::unique_ptr<Encoder>, static_cast<size_t>(ContentEncoding::Count)> encoders = []
+        {
+            std::array<std::unique_ptr<Encoder>, static_cast<size_t>(ContentEncoding::Count)> defaults;
+            defaults[static_cast<size_t>(ContentEncoding::Gzip)] = std::make_unique<GzipEncoder>();
+            return defaults;
+        }();
+        return encoders;
+    }
+};
 
-        // Initialize the zlib compression
-        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION,  // set compression level
-                         Z_DEFLATED,                  // use deflate compression method
-                         15 | 16,                     // 15 | 16 for gzip encoding
-                         8,                           // set window size
-                         Z_DEFAULT_STRATEGY) != Z_OK) // use default compression strategy
+// Type-erased, move-only callable; captures up to INLINE_SIZE bytes live inside the task itself,
+// so submitting a connection handler does not allocate
+class Task
+{
+public:
+    Task() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F &&f)
+    {
+        using Callable = std::decay_t<F>;
+        if constexpr (sizeof(Callable) <= INLINE_SIZE && alignof(Callable) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Callable>)
         {
-            throw std::runtime_error("Failed to initialize zlib");
+            new (storage) Callable(std::forward<F>(f));
+            ops = &inlineOps<Callable>;
+        }
+        else
+        {
+            *reinterpret_cast<Callable **>(storage) = new Callable(std::forward<F>(f));
+            ops = &heapOps<Callable>;
         }
+    }
 
-        // set input data for compression
-        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data())); // input data
-        zs.avail_in = data.size();
-        // size of input data
+    Task(Task &&other) noexcept : ops(std::exchange(other.ops, nullptr))
+    {
+        if (ops)
+        {
+            ops->relocate(other.storage, storage);
+        }
+    }
 
-        int ret;                         // variable to hold return status of compression
-        const size_t bufferSize = 32768; // define size of output buffer (32KB)
-        std::string compressed;          // string to hold final compressed data
-        char outbuffer[bufferSize];      // buffer for compressed output
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            ops = std::exchange(other.ops, nullptr);
+            if (ops)
+            {
+                ops->relocate(other.storage, storage);
+            }
+        }
+        return *this;
+    }
 
-        // compress data in a loop until all data is processed
-        do
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    ~Task()
+    {
+        reset();
+    }
+
+    explicit operator bool() const
+    {
+        return ops != nullptr;
+    }
+
+    void operator()()
+    {
+        ops->invoke(storage);
+    }
+
+    void reset()
+    {
+        if (ops)
         {
-            zs.next_out = reinterpret_cast<Bytef *>(outbuffer); // output buffer for compressed data
-            zs.avail_out = bufferSize;                          // size of output buffer
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
 
-            ret = deflate(&zs, Z_FINISH); // perform compression operation
+private:
+    static constexpr size_t INLINE_SIZE = 64;
 
-            if (compressed.size() < zs.total_out) // append compressed data to output string
+    struct Ops
+    {
+        void (*invoke)(void *storage);
+        void (*relocate)(void *from, void *to); // move into to, destroy from
+        void (*destroy)(void *storage);
+    };
+
+    template <typename Callable>
+    static constexpr Ops inlineOps = {
+        [](void *storage)
+        { (*static_cast<Callable *>(storage))(); },
+        [](void *from, void *to)
+        {
+            new (to) Callable(std::move(*static_cast<Callable *>(from)));
+            static_cast<Callable *>(from)->~Callable();
+        },
+        [](void *storage)
+        { static_cast<Callable *>(storage)->~Callable(); }};
+
+    template <typename Callable>
+    static constexpr Ops heapOps = {
+        [](void *storage)
+        { (**static_cast<Callable **>(storage))(); },
+        [](void *from, void *to)
+        { *static_cast<Callable **>(to) = *static_cast<Callable **>(from); },
+        [](void *storage)
+        { delete *static_cast<Callable **>(storage); }};
+
+    alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+    const Ops *ops = nullptr;
+};
+
+// Bounded lock-free multi-producer multi-consumer ring of tasks (Vyukov): a worker's own queue, filled by the
+// dispatcher and drained by its owner and by idle workers stealing from it
+class TaskRing
+{
+public:
+    explicit TaskRing(size_t capacity) : cells(std::make_unique<Cell[]>(capacity)), mask(capacity - 1)
+    {
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // moves from task only on success, false if the ring is full
+    bool push(Task &task)
+    {
+        size_t position = tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell &cell = cells[position & mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
             {
-                compressed.append(outbuffer, zs.total_out - compressed.size());
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.task = std::move(task);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
             }
-        } while (ret == Z_OK); // continue until no more data to compress
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
 
-        // check if compression completed successfully
-        if (ret != Z_STREAM_END)
+    bool pop(Task &task)
+    {
+        size_t position = head.load(std::memory_order_relaxed);
+        while (true)
         {
-            deflateEnd(&zs); // clean up z_stream object
-            throw std::runtime_error("Failed to compress data");
+            Cell &cell = cells[position & mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0)
+            {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    task = std::move(cell.task);
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = head.load(std::memory_order_relaxed);
+            }
         }
+    }
 
-        deflateEnd(&zs);   // clean up and free resources allocated by zlib
-        return compressed; // return compressed data
+    [[nodiscard]] bool empty() const
+    {
+        return head.load(std::memory_order_relaxed) >= tail.load(std::memory_order_relaxed);
     }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Task task;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0}; // consumers, own cache line
+    alignas(64) std::atomic<size_t> tail{0}; // producers, own cache line
 };
 
+// Work-stealing pool: every worker has its own ring, submissions are spread round-robin (or kept local when
+// submitted from a worker), idle workers steal from the others, spin briefly and then park on an epoch counter
 class ThreadPool
 {
 public:
@@ -668,6 +3748,34 @@ public:
     ThreadPool(const ThreadPool &) = delete;
     ThreadPool &operator=(const ThreadPool &) = delete;
 
+    // fire-and-forget submission, no future and no allocation for small captures
+    template <typename F>
+    void submit(F &&f)
+    {
+        if (stop_flag.load(std::memory_order_acquire))
+        {
+            throw std::runtime_error("Cannot enqueue on stopped ThreadPool");
+        }
+
+        Task task(std::forward<F>(f));
+        const size_t count = rings.size();
+        const size_t first = currentPool == this ? currentWorker : nextWorker.fetch_add(1, std::memory_order_relaxed);
+        bool queued = false;
+        for (size_t i = 0; i < count && !queued; ++i)
+        {
+            queued = rings[(first + i) % count]->push(task);
+        }
+        if (!queued)
+        {
+            // every ring is full, rare enough for a lock
+            std::lock_guard<std::mutex> lock(overflowMutex);
+            overflow.push_back(std::move(task));
+            overflowSize.fetch_add(1, std::memory_order_release);
+        }
+
+        wake();
+    }
+
     // template method to enqueue tasks and get future results
     template <typename F, typename... Args>
     auto enqueue(F &&f, Args &&...args)
@@ -680,32 +3788,20 @@ public:
             std::bind(std::forward<F>(f), std::forward<Args>(args)...));
 
         std::future<return_type> res = task->get_future();
-
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            if (stop_flag)
-            {
-                throw std::runtime_error("Cannot enqueue on stopped ThreadPool");
-            }
-
-            // wrap packaged task in a void function for queue
-            tasks.emplace([task]()
-                          { (*task)(); });
-        }
-
-        condition.notify_one(); // notify one thread that a task is available
+        submit([task]()
+               { (*task)(); });
         return res;
     }
 
-    // stop thread pool and wait for all tasks to complete
+    // stop thread pool, workers finish the queued tasks before they exit
     void stop()
     {
+        stop_flag.store(true, std::memory_order_release);
+        epoch.fetch_add(1, std::memory_order_seq_cst);
         {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            stop_flag = true;
+            std::lock_guard<std::mutex> lock(parkMutex);
         }
-
-        condition.notify_all();
+        parked.notify_all();
 
         // join all worker threads
         for (std::thread &worker : workers)
@@ -717,10 +3813,6 @@ public:
         }
 
         workers.clear();
-
-        // clear any remaining tasks
-        std::queue<std::function<void()>> empty;
-        std::swap(tasks, empty);
     }
 
     // get number of worker threads
@@ -730,45 +3822,140 @@ public:
     }
 
 private:
+    static constexpr size_t RING_CAPACITY = 1024; // per worker, power of two
+    static constexpr int SPIN_LIMIT = 2048;       // empty polls before a worker parks
+
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex queueMutex;
-    std::condition_variable condition;
+    std::vector<std::unique_ptr<TaskRing>> rings; // one per worker
+    std::deque<Task> overflow;                    // used only when every ring is full
+    std::mutex overflowMutex;
+    std::atomic<size_t> overflowSize{0};
+    std::atomic<size_t> nextWorker{0};  // round-robin target for submissions from outside the pool
+    std::atomic<uint32_t> epoch{0};     // bumped on every submission, parked workers wait for it to move
+    std::atomic<uint32_t> sleepers{0};  // parked workers, submissions skip the wake-up syscall when zero
+    std::mutex parkMutex;
+    std::condition_variable parked;
+    std::atomic<uint32_t> spinning{0};  // workers currently polling for work before parking
+    uint32_t maxSpinning = 0;           // spinning only pays off with spare cores, none on a single core
     std::atomic<bool> stop_flag{false};
 
-    // initialize thread pool with specified number of threads
-    void start(size_t numThreads)
+    static inline thread_local ThreadPool *currentPool = nullptr; // pool of the calling worker thread
+    static inline thread_local size_t currentWorker = 0;          // its index in that pool
+
+    void wake()
     {
-        workers.reserve(numThreads); // prevent vector reallocation
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(parkMutex); // a parking worker either sees the new epoch or gets the notify
+            }
+            parked.notify_one();
+        }
+    }
 
-        for (size_t i = 0; i < numThreads; ++i)
+    // own ring first, then the overflow queue, then steal from the others
+    bool take(size_t index, Task &task)
+    {
+        if (rings[index]->pop(task))
         {
-            workers.emplace_back([this]
-                                 {
-                while (true) {
-                    std::function<void()> task;// define a task to execute
+            return true;
+        }
+        if (overflowSize.load(std::memory_order_acquire) > 0)
+        {
+            std::lock_guard<std::mutex> lock(overflowMutex);
+            if (!overflow.empty())
+            {
+                task = std::move(overflow.front());
+                overflow.pop_front();
+                overflowSize.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (size_t i = 1; i < rings.size(); ++i)
+        {
+            if (rings[(index + i) % rings.size()]->pop(task))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
 
-                    {
-                        std::unique_lock<std::mutex> lock(queueMutex);
+    static void cpuRelax()
+    {
+#if defined(__SSE2__)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    void run(size_t index)
+    {
+        currentPool = this;
+        currentWorker = index;
+        while (true)
+        {
+            Task task;
+            if (take(index, task))
+            {
+                task(); // execute task
+                continue;
+            }
+            if (stop_flag.load(std::memory_order_acquire))
+            {
+                return; // stopped and nothing left to run
+            }
 
-                        condition.wait(lock, [this] {
-                            return stop_flag || !tasks.empty();// wait for a task or stop flag
-                        });
+            // poll a little longer before paying for a sleep and a wake-up, a few workers at a time
+            if (spinning.fetch_add(1, std::memory_order_relaxed) < maxSpinning)
+            {
+                for (int i = 0; i < SPIN_LIMIT && !task && !stop_flag.load(std::memory_order_relaxed); ++i)
+                {
+                    cpuRelax();
+                    take(index, task);
+                }
+            }
+            spinning.fetch_sub(1, std::memory_order_relaxed);
+            if (task)
+            {
+                task();
+                continue;
+            }
 
-                        if (stop_flag && tasks.empty()) {// check if thread pool is stopped
-                            return;
-                        }
+            // park: a submission after the epoch is read changes it, so the wait returns at once
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            const uint32_t seen = epoch.load(std::memory_order_seq_cst);
+            if (!take(index, task))
+            {
+                std::unique_lock<std::mutex> lock(parkMutex);
+                parked.wait(lock, [this, seen]
+                            { return epoch.load(std::memory_order_seq_cst) != seen || stop_flag.load(std::memory_order_acquire); });
+            }
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+            if (task)
+            {
+                task();
+            }
+        }
+    }
 
-                        if (!tasks.empty()) {
-                            task = std::move(tasks.front());// get next task
-                            tasks.pop();
-                        }
-                    }
+    // initialize thread pool with specified number of threads
+    void start(size_t numThreads)
+    {
+        maxSpinning = std::min<uint32_t>(static_cast<uint32_t>(numThreads), std::thread::hardware_concurrency() / 2);
+        rings.reserve(numThreads);
+        for (size_t i = 0; i < numThreads; ++i)
+        {
+            rings.push_back(std::make_unique<TaskRing>(RING_CAPACITY));
+        }
 
-                    if (task) {
-                        task();// execute task
-                    }
-                } });
+        workers.reserve(numThreads); // prevent vector reallocation
+        for (size_t i = 0; i < numThreads; ++i)
+        {
+            workers.emplace_back([this, i]
+                                 { run(i); });
         }
     }
 };
@@ -781,7 +3968,7 @@ public:
     void bind();
     void listen();
     void closeSocket();
-    int acceptConnection(std::string &clientIp);
+    int acceptConnection(std::string &clientIp, struct in6_addr &clientAddress);
     int getSocketFd() const;
 
     static std::string durationToString(const std::chrono::steady_clock::duration &duration)
@@ -803,14 +3990,14 @@ Socket::Socket(int port) : port(port)
     server_fd = socket(AF_INET6, SOCK_STREAM, 0);
     if (server_fd == -1)
     {
-        Logger::getInstance()->error("Socket creation failed: " + std::string(strerror(errno)));
+        LOG_ERROR("Socket creation failed: " + std::string(strerror(errno)));
         throw std::runtime_error("Socket creation failed!");
     }
 
     int no = 0;
     if (setsockopt(server_fd, IPPROTO_IPV6, IPV6_V6ONLY, &no, sizeof(no)) < 0)
     {
-        Logger::getInstance()->error("Failed to set IPV6_V6ONLY to 0: " + std::string(strerror(errno)));
+        LOG_ERROR("Failed to set IPV6_V6ONLY to 0: " + std::string(strerror(errno)));
         close(server_fd);
         throw std::runtime_error("Failed to configure dual-stack socket!");
     }
@@ -818,16 +4005,19 @@ Socket::Socket(int port) : port(port)
 
 Socket::~Socket()
 {
-    Logger::getInstance()->info("Closing server socket");
+    LOG_INFO("Closing server socket");
     close(server_fd);
 }
 
 void Socket::bind()
 {
     int opt = 1;
-    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt)) < 0) // Set socket options
+    // SO_REUSEPORT lets every reactor bind its own listener to the same port,
+    // the kernel then load balances incoming connections across them
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0 ||
+        setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) // Set socket options
     {
-        Logger::getInstance()->error("Failed to set socket options: " + std::string(strerror(errno)));
+        LOG_ERROR("Failed to set socket options: " + std::string(strerror(errno)));
         throw std::runtime_error("Failed to set socket options");
     }
 
@@ -840,11 +4030,11 @@ void Socket::bind()
     if (::bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) // Bind socket to address and port
     {
         std::string errorMsg = "Bind failed: " + std::string(strerror(errno));
-        Logger::getInstance()->error(errorMsg);
+        LOG_ERROR(errorMsg);
         throw std::runtime_error(errorMsg);
     }
 
-    Logger::getInstance()->success("Socket successfully bound to port " + std::to_string(port));
+    LOG_SUCCESS("Socket successfully bound to port " + std::to_string(port));
 }
 
 void Socket::listen()
@@ -861,7 +4051,7 @@ void Socket::closeSocket()
 }
 
 [[nodiscard]]
-int Socket::acceptConnection(std::string &clientIp)
+int Socket::acceptConnection(std::string &clientIp, struct in6_addr &clientAddress)
 {
     struct sockaddr_in6 address;
     socklen_t addrlen = sizeof(address);
@@ -875,18 +4065,19 @@ int Socket::acceptConnection(std::string &clientIp)
             inet_ntop(AF_INET6, &address.sin6_addr, ipstr, sizeof(ipstr)); // Convert IPv6 address to string
         }
         clientIp = ipstr;
-        Logger::getInstance()->success("New connection accepted from " + clientIp);
+        clientAddress = address.sin6_addr; // dual-stack socket, IPv4 peers arrive as ::ffff:a.b.c.d
+        LOG_DEBUG("New connection accepted from " + clientIp);
 
         int flags = fcntl(new_socket, F_GETFL, 0);
         if (flags == -1)
         {
-            Logger::getInstance()->error("Failed to get socket flags");
+            LOG_ERROR("Failed to get socket flags");
             close(new_socket);
             return -1;
         }
         if (fcntl(new_socket, F_SETFL, flags | O_NONBLOCK) == -1)
         {
-            Logger::getInstance()->error("Failed to set socket to non-blocking mode");
+            LOG_ERROR("Failed to set socket to non-blocking mode");
             close(new_socket);
             return -1;
         }
@@ -894,7 +4085,7 @@ int Socket::acceptConnection(std::string &clientIp)
     else
     {
         clientIp = "-";
-        Logger::getInstance()->error("Failed to accept connection");
+        LOG_ERROR("Failed to accept connection");
     }
     return new_socket;
 }
@@ -905,21 +4096,131 @@ int Socket::getSocketFd() const
     return server_fd;
 }
 
+// Per-connection response state, whatever the socket didn't accept is parked
+// here on EAGAIN and flushed by Http::resumeSend once epoll reports EPOLLOUT
+struct SendState
+{
+    // unsent in-memory bytes, owner pins the memory data points into;
+    // a chunk without data is a slice of fileFd starting at fileOffset (multipart ranges)
+    struct Chunk
+    {
+        std::shared_ptr<const void> owner; // cached body or owned copy of a transient buffer
+        const char *data;                  // first unsent byte, nullptr for a file slice
+        size_t size;                       // unsent bytes
+        off_t fileOffset = 0;              // next file offset of a file slice
+    };
+
+    std::deque<Chunk> chunks;     // queued header/body chunks and file slices, sent before the file range
+    int fileFd = -1;              // file streamed after buffer
+    bool ownsFile = false;        // whether fileFd must be closed by this state
+    off_t fileOffset = 0;         // next file offset to send (sendfile offset / mmap cursor)
+    off_t fileEnd = 0;            // end of file range to send (exclusive)
+    void *mmapAddr = MAP_FAILED;  // mmap fallback mapping when sendfile is unsupported
+    size_t mmapLength = 0;        // length of mmap fallback mapping
+    bool failed = false;          // hard send error, connection must be closed
+    bool closeAfterSend = false;  // response announced Connection: close
+    bool chunkedAllowed = true;   // current request is HTTP/1.1, chunked transfer coding may be used
+    std::unique_ptr<StreamEncoder> encoder; // compresses fileFd/encodeSource range into chunked output
+    SharedBuffer encodeSource;    // in-memory source for encoder instead of fileFd
+    uint64_t bytesSent = 0;       // everything written to the socket over the connection's lifetime
+
+    // what the current response turned out to be, for the access log
+    uint16_t status = 0;
+    bool cacheHit = false;
+    ContentEncoding encoding = ContentEncoding::Identity;
+
+    SendState() = default;
+    SendState(const SendState &) = delete;
+    SendState &operator=(const SendState &) = delete;
+    ~SendState() { reset(); }
+
+    [[nodiscard]] bool pending() const
+    {
+        return !chunks.empty() || fileFd != -1 || mmapAddr != MAP_FAILED || encoder;
+    }
+
+    // release file and mapping, keep failed flag for caller to inspect
+    void reset()
+    {
+        chunks.clear();
+        if (ownsFile && fileFd != -1)
+            close(fileFd);
+        fileFd = -1;
+        ownsFile = false;
+        if (mmapAddr != MAP_FAILED)
+            munmap(mmapAddr, mmapLength);
+        mmapAddr = MAP_FAILED;
+        mmapLength = 0;
+        fileOffset = fileEnd = 0;
+        encoder.reset();
+        encodeSource.reset();
+    }
+};
+
+// request headers that make a response conditional or partial
+struct RequestConditions
+{
+    std::string_view range;           // Range, byte ranges of the identity representation
+    std::string_view ifRange;         // If-Range, Range only applies while this validator still matches
+    std::string_view ifNoneMatch;     // If-None-Match, 304 when one of the entity tags is current
+    std::string_view ifModifiedSince; // If-Modified-Since, 304 when unchanged since, unless If-None-Match is sent
+};
+
 class Http
 {
 public:
-    static std::string getRequestPath(const std::string &request);
+    // outcome of a non-blocking send attempt
+    enum class SendStatus
+    {
+        Complete,   // everything written
+        WouldBlock, // socket buffer full, remainder parked in SendState
+        Failed      // hard error, connection should be closed
+    };
+
+    // keep-alive policy advertised in response headers and enforced by Server
+    static constexpr int KEEP_ALIVE_TIMEOUT = 60;    // idle seconds before a persistent connection is closed
+    static constexpr int KEEP_ALIVE_MAX = 1000;      // requests served per connection
+
+    static void sendError(int client_socket, int statusCode, SendState &state, const std::string &clientIp);
+    static size_t sendBuffers(int client_socket, struct iovec *iov, int iovcnt,
+                              SendState &state, const std::string &clientIp,
+                              const std::shared_ptr<const void> *owners = nullptr);
     static void sendResponse(int client_socket, const std::string &content,
                              const std::string &mimeType, int statusCode,
-                             const std::string &clientIp, bool isIndex = false,
-                             Middleware *middleware = nullptr, Cache *cache = nullptr);
+                             const std::string &clientIp, SendState &sendState,
+                             bool isIndex = false,
+                             Middleware *middleware = nullptr, Cache *cache = nullptr,
+                             const RequestConditions &conditions = {}, const OpenFile *openFile = nullptr);
+    static bool sendPrecompressed(int client_socket, const std::string &filePath,
+                                  const std::string &mimeType, ContentEncoding encoding,
+                                  const std::string &clientIp, SendState &sendState,
+                                  bool isIndex = false, const RequestConditions &conditions = {},
+                                  const OpenFile *openFile = nullptr);
+    static SendStatus resumeSend(int client_socket, SendState &state, const std::string &clientIp);
     static bool isAssetRequest(const std::string &path);
+    static size_t preload(Cache *cache, const OpenFile &file, size_t budget);
 
 private:
     // Constants for optimized I/O
     static constexpr size_t BUFFER_SIZE = 65536;      // 64KB buffer size
     static constexpr size_t ALIGNMENT = 512;          // memory alignment boundary
     static constexpr size_t SENDFILE_CHUNK = 1048576; // 1MB sendfile chunk size
+    static constexpr size_t STREAM_COMPRESS_THRESHOLD = 1048576; // larger bodies are compressed on the fly, chunked
+    static constexpr size_t MAX_RANGES = 16;          // more ranges than this and the Range header is ignored
+
+    // inclusive byte range of the representation
+    struct ByteRange
+    {
+        size_t first;
+        size_t last;
+    };
+
+    enum class RangeStatus
+    {
+        Ignored,       // no usable Range, send the full representation
+        Satisfiable,   // at least one range within the representation
+        Unsatisfiable  // valid ranges that all start past the end
+    };
     static constexpr int MAX_IOV = IOV_MAX;           // maximum iovec array size
 
     // Socket option settings
@@ -949,21 +4250,28 @@ private:
     class FileGuard
     {
         int fd;
+        bool owned = true; // false for descriptors borrowed from the FileCache
 
     public:
         FileGuard() : fd(-1) {}
         explicit FileGuard(int f) : fd(f) {}
         ~FileGuard()
         {
-            if (fd != -1)
+            if (fd != -1 && owned)
                 close(fd);
         }
         int get() const { return fd; }
         void reset(int f = -1)
         {
-            if (fd != -1)
+            if (fd != -1 && owned)
                 close(fd);
             fd = f;
+            owned = true;
+        }
+        void borrow(int f)
+        {
+            reset(f);
+            owned = false;
         }
     };
 
@@ -979,47 +4287,72 @@ private:
             if (addr != MAP_FAILED)
                 munmap(addr, length);
         }
+        void *release() { return std::exchange(addr, MAP_FAILED); }
     };
 
     // Helper functions declarations
     static bool setupSocketOptions(int client_socket, int cork, const std::string &clientIp);
     static bool handleFileContent(FileGuard &fileGuard,
                                   const std::string &filePath,
-                                  std::pmr::vector<char> &fileContent,
                                   size_t &fileSize,
                                   time_t &lastModified,
                                   const std::string &clientIp);
-    static bool compressContent(Middleware *middleware,
-                                const std::string &mimeType,
-                                size_t fileSize,
-                                std::pmr::vector<char> &fileContent,
-                                std::pmr::string &compressedContent,
-                                bool cacheHit,
-                                FileGuard &fileGuard,
-                                std::pmr::monotonic_buffer_resource &pool);
+    static SharedBuffer readFile(FileGuard &fileGuard, size_t fileSize);
+    static SharedBuffer compressContent(Middleware *middleware, const SharedBuffer &content);
     static std::string generateHeaders(int statusCode,
                                        const std::string &mimeType,
                                        size_t fileSize,
                                        time_t lastModified,
-                                       bool isCompressed);
+                                       ContentEncoding encoding,
+                                       bool keepAlive,
+                                       bool chunked = false,
+                                       const std::string &extraHeaders = {});
     static size_t sendWithWritev(int client_socket,
                                  const std::string &headerStr,
-                                 const std::pmr::string &compressedContent,
-                                 const std::pmr::vector<char> &fileContent,
-                                 bool isCompressed,
-                                 bool cacheHit,
-                                 const std::string &clientIp);
+                                 const SharedBuffer &body,
+                                 const std::string &clientIp,
+                                 SendState &state);
     static size_t sendLargeFile(int client_socket,
                                 FileGuard &fileGuard,
                                 size_t fileSize,
-                                const std::string &clientIp);
+                                const std::string &clientIp,
+                                SendState &state,
+                                size_t offset = 0);
+    static SendStatus streamFile(int client_socket, SendState &state, const std::string &clientIp);
+    static size_t sendEncodedStream(int client_socket,
+                                    FileGuard &fileGuard,
+                                    const SharedBuffer &source,
+                                    size_t fileSize,
+                                    std::unique_ptr<StreamEncoder> encoder,
+                                    const std::string &clientIp,
+                                    SendState &state);
+    static SendStatus streamEncoded(int client_socket, SendState &state, const std::string &clientIp);
+    static SendStatus flushChunks(int client_socket, SendState &state, const std::string &clientIp);
+    static SendStatus sendFileSlice(int client_socket, SendState &state, SendState::Chunk &slice,
+                                    const std::string &clientIp);
+    static bool parseHttpDate(std::string_view value, time_t &result);
+    static std::string makeETag(const struct stat &fileStat, ContentEncoding encoding = ContentEncoding::Identity);
+    static bool isNotModified(const RequestConditions &conditions, const std::string &etag, time_t lastModified);
+    static size_t sendNotModified(int client_socket, const std::string &etag, time_t lastModified,
+                                  bool varies, const std::string &clientIp, SendState &state);
+    static RangeStatus parseRanges(const RequestConditions &conditions, size_t size, time_t lastModified,
+                                   const std::string &etag, std::vector<ByteRange> &ranges);
+    static size_t sendRanges(int client_socket,
+                             const std::string &mimeType,
+                             size_t fileSize,
+                             time_t lastModified,
+                             const std::string &etag,
+                             const std::vector<ByteRange> &ranges,
+                             const SharedBuffer &body,
+                             FileGuard &fileGuard,
+                             const std::string &clientIp,
+                             SendState &state);
     static void updateCache(Cache *cache,
                             const std::string &filePath,
                             const std::string &mimeType,
                             time_t lastModified,
                             FileGuard &fileGuard,
-                            size_t fileSize,
-                            std::pmr::monotonic_buffer_resource &pool);
+                            size_t fileSize);
 };
 bool Http::isAssetRequest(const std::string &path)
 {
@@ -1123,28 +4456,61 @@ bool Http::isAssetRequest(const std::string &path)
     return false;
 }
 
-[[nodiscard]]
-std::string Http::getRequestPath(const std::string &request)
+// small plain-text error response, used for protocol level failures
+void Http::sendError(int client_socket, int statusCode, SendState &state, const std::string &clientIp)
 {
-    size_t pos1 = request.find("GET ");
-    size_t pos2 = request.find(" HTTP/");
-    if (pos1 == std::string::npos || pos2 == std::string::npos) // Check if request is valid
+    const char *reason;
+    switch (statusCode)
     {
-        return "/";
+    case 400:
+        reason = "Bad Request";
+        break;
+    case 405:
+        reason = "Method Not Allowed";
+        break;
+    case 406:
+        reason = "Not Acceptable";
+        break;
+    case 413:
+        reason = "Content Too Large";
+        break;
+    case 431:
+        reason = "Request Header Fields Too Large";
+        break;
+    case 501:
+        reason = "Not Implemented";
+        break;
+    default:
+        reason = "Internal Server Error";
+        statusCode = 500;
+        break;
     }
-    return request.substr(pos1 + 4, pos2 - (pos1 + 4));
+
+    state.status = static_cast<uint16_t>(statusCode);
+    std::string response = "HTTP/1.1 " + std::to_string(statusCode) + " " + reason + "\r\n"
+                           "Content-Type: text/plain\r\n"
+                           "Content-Length: " + std::to_string(strlen(reason)) + "\r\n" +
+                           (statusCode == 405 ? "Allow: GET\r\n" : "") +
+                           (statusCode == 406 ? "Vary: Accept-Encoding\r\n" : "") +
+                           (state.closeAfterSend ? "Connection: close\r\n" : "") +
+                           "\r\n" + reason;
+
+    struct iovec iov[1];
+    iov[0].iov_base = response.data();
+    iov[0].iov_len = response.size();
+    sendBuffers(client_socket, iov, 1, state, clientIp);
 }
+
 void Http::sendResponse(int client_socket, const std::string &filePath,
                         const std::string &mimeType, int statusCode,
-                        const std::string &clientIp, bool isIndex,
-                        Middleware *middleware, Cache *cache)
+                        const std::string &clientIp, SendState &sendState,
+                        bool isIndex, Middleware *middleware, Cache *cache,
+                        const RequestConditions &conditions, const OpenFile *openFile)
 {
-    // Create a memory resource for this request
-    std::pmr::monotonic_buffer_resource pool(64 * 1024); // 64KB initial size
-
     // Performance metrics
     auto startTime = std::chrono::steady_clock::now();
     size_t totalBytesSent = 0;
+    sendState.status = static_cast<uint16_t>(statusCode);
 
     // Socket options
     int cork = 1;
@@ -1157,64 +4523,182 @@ void Http::sendResponse(int client_socket, const std::string &filePath,
     }
 
     // File content and cache handling
-    std::pmr::vector<char> fileContent{&pool};
+    SharedBuffer body; // in-memory body (identity or encoded), shared with the cache and pinned for this response
     size_t fileSize;
     time_t lastModified;
     bool cacheHit = false;
+    bool isCompressed = false;
+
+    // byte ranges always address the identity representation
+    const bool rangeRequested = statusCode == 200 && !conditions.range.empty();
+
+    // compressible types are looked up as an encoded variant first, images only when identity was refused
+    const ContentEncoding encoding = middleware ? middleware->contentEncoding() : ContentEncoding::Identity;
+    const bool encodingRequired = middleware && middleware->encodingRequired();
+    const bool wantCompressed = encoding != ContentEncoding::Identity && !rangeRequested &&
+                                (encodingRequired ||
+                                 (Compression::shouldCompress(mimeType, std::numeric_limits<size_t>::max()) &&
+                                  mimeType.find("image/") == std::string::npos));
+
+    // Validators come from one stat of the path, taken before any open, cache lookup or compression;
+    // a file from the FileCache already carries it
+    struct stat fileStat;
+    const bool haveStat = statusCode == 200 &&
+                          (openFile ? (fileStat = openFile->st, true) : stat(filePath.c_str(), &fileStat) == 0);
+    if (haveStat && isNotModified(conditions, makeETag(fileStat), fileStat.st_mtime))
+    {
+        // same coding decision the full response would make, so the refreshed ETag matches it
+        const bool encoded = wantCompressed &&
+                             (encodingRequired || Compression::shouldCompress(mimeType, static_cast<size_t>(fileStat.st_size)));
+        sendState.status = 304;
+        totalBytesSent += sendNotModified(client_socket, makeETag(fileStat, encoded ? encoding : ContentEncoding::Identity),
+                                          fileStat.st_mtime, encoded, clientIp, sendState);
+        if (isIndex)
+        {
+            LOG_INFO("Response sent: status=304, path=" + filePath, clientIp);
+        }
+        return;
+    }
 
     // Try to get content from cache
     if (cache && statusCode == 200)
     {
         std::string cachedMimeType;
-        cacheHit = cache->get(filePath, fileContent, cachedMimeType, lastModified);
+        if (wantCompressed && cache->get(filePath, body, cachedMimeType, lastModified, encoding))
+        {
+            cacheHit = isCompressed = true; // encoded once per file version, served by reference
+        }
+        else
+        {
+            cacheHit = cache->get(filePath, body, cachedMimeType, lastModified);
+        }
+        if (cacheHit && haveStat && lastModified != fileStat.st_mtime)
+        {
+            // the file changed since it was cached, the entry and its variants are stale
+            cache->remove(filePath);
+            cacheHit = isCompressed = false;
+            body.reset();
+        }
         if (cacheHit)
         {
-            fileSize = fileContent.size();
-            Logger::getInstance()->info("Cache hit for: " + filePath, clientIp);
+            fileSize = body->size();
+            sendState.cacheHit = true;
+            LOG_DEBUG("Cache hit for: " + filePath, clientIp);
         }
     }
 
     // Handle file if not in cache
     FileGuard fileGuard;
-    if (!cacheHit)
+    if (!cacheHit && openFile)
     {
-        if (!handleFileContent(fileGuard, filePath, fileContent, fileSize, lastModified, clientIp))
+        // the cached descriptor is shared, every read below uses explicit offsets
+        fileGuard.borrow(openFile->fd);
+        fileSize = static_cast<size_t>(openFile->st.st_size);
+        lastModified = openFile->st.st_mtime;
+    }
+    else if (!cacheHit)
+    {
+        if (!handleFileContent(fileGuard, filePath, fileSize, lastModified, clientIp))
         {
             return;
         }
     }
 
-    // Compression handling
-    bool isCompressed = false;
-    std::pmr::string compressedContent{&pool};
-
-    if (middleware && Compression::shouldCompress(mimeType, fileSize) &&
-        mimeType.find("image/") == std::string::npos)
+    // Partial content, served from the cached buffer or with sendfile from the requested offsets
+    bool responded = false;
+    if (rangeRequested)
     {
-        isCompressed = compressContent(middleware, mimeType, fileSize, fileContent,
-                                       compressedContent, cacheHit, fileGuard, pool);
-        if (isCompressed)
+        std::vector<ByteRange> ranges;
+        switch (parseRanges(conditions, fileSize, lastModified, haveStat ? makeETag(fileStat) : std::string(), ranges))
         {
-            fileSize = compressedContent.size();
+        case RangeStatus::Satisfiable:
+            sendState.status = 206;
+            totalBytesSent += sendRanges(client_socket, mimeType, fileSize, lastModified,
+                                         haveStat ? makeETag(fileStat) : std::string(), ranges, body, fileGuard,
+                                         clientIp, sendState);
+            responded = true;
+            break;
+        case RangeStatus::Unsatisfiable:
+        {
+            sendState.status = 416;
+            std::string headerStr = generateHeaders(416, mimeType, 0, lastModified, ContentEncoding::Identity,
+                                                    !sendState.closeAfterSend, false,
+                                                    "Content-Range: bytes */" + std::to_string(fileSize) + "\r\n");
+            totalBytesSent += sendWithWritev(client_socket, headerStr, nullptr, clientIp, sendState);
+            responded = true;
+            break;
+        }
+        case RangeStatus::Ignored:
+            break;
         }
     }
 
-    // Generate response headers
-    std::string headerStr = generateHeaders(statusCode, mimeType, fileSize, lastModified, isCompressed);
+    // no cached variant, the body has to be encoded for this response
+    const bool encodeNow = !responded && !isCompressed && wantCompressed &&
+                           (encodingRequired || Compression::shouldCompress(mimeType, fileSize));
 
-    // Send headers and content using writev
-    totalBytesSent += sendWithWritev(client_socket, headerStr, compressedContent,
-                                     fileContent, isCompressed, cacheHit, clientIp);
+    // Large bodies are compressed on the fly into a chunked response, memory stays bounded by one buffer
+    if (encodeNow && fileSize > STREAM_COMPRESS_THRESHOLD && sendState.chunkedAllowed)
+    {
+        if (auto encoder = Compression::streamEncoder(encoding))
+        {
+            std::string headerStr = generateHeaders(statusCode, mimeType, fileSize, lastModified, encoding,
+                                                    !sendState.closeAfterSend, true,
+                                                    haveStat ? "ETag: " + makeETag(fileStat, encoding) + "\r\n" : "");
+            totalBytesSent += sendWithWritev(client_socket, headerStr, nullptr, clientIp, sendState);
+            sendState.encoding = encoding;
+            if (!sendState.failed)
+            {
+                totalBytesSent += sendEncodedStream(client_socket, fileGuard, body, fileSize, std::move(encoder),
+                                                    clientIp, sendState);
+            }
+            responded = true;
+        }
+    }
 
-    // Handle large file transfer using sendfile or mmap
-    if (!isCompressed && !cacheHit && fileGuard.get() != -1)
+    if (!responded)
     {
-        totalBytesSent += sendLargeFile(client_socket, fileGuard, fileSize, clientIp);
+        // Compression handling, the result is stored as a cache variant next to the identity content
+        if (encodeNow)
+        {
+            SharedBuffer identity = cacheHit ? body : readFile(fileGuard, fileSize);
+            SharedBuffer encoded = identity ? compressContent(middleware, identity) : nullptr;
+            if (encoded)
+            {
+                if (cache && statusCode == 200)
+                {
+                    if (!cacheHit)
+                    {
+                        cache->set(filePath, identity, mimeType, lastModified);
+                    }
+                    cache->setVariant(filePath, encoding, encoded, lastModified);
+                }
+                body = std::move(encoded);
+                fileSize = body->size();
+                isCompressed = true;
+            }
+        }
+
+        // Generate response headers
+        const ContentEncoding bodyEncoding = isCompressed ? encoding : ContentEncoding::Identity;
+        sendState.encoding = bodyEncoding;
+        std::string headerStr = generateHeaders(statusCode, mimeType, fileSize, lastModified, bodyEncoding,
+                                                !sendState.closeAfterSend, false,
+                                                haveStat ? "ETag: " + makeETag(fileStat, bodyEncoding) + "\r\n" : "");
 
-        // Update cache if needed
-        if (cache && statusCode == 200)
+        // Send headers and in-memory content using writev
+        totalBytesSent += sendWithWritev(client_socket, headerStr, body, clientIp, sendState);
+
+        // Handle large file transfer using sendfile or mmap
+        if (!body && fileGuard.get() != -1 && !sendState.failed)
         {
-            updateCache(cache, filePath, mimeType, lastModified, fileGuard, fileSize, pool);
+            totalBytesSent += sendLargeFile(client_socket, fileGuard, fileSize, clientIp, sendState);
+
+            // Update cache if needed
+            if (cache && statusCode == 200)
+            {
+                updateCache(cache, filePath, mimeType, lastModified, fileGuard, fileSize);
+            }
         }
     }
 
@@ -1224,7 +4708,7 @@ void Http::sendResponse(int client_socket, const std::string &filePath,
 
     if (isIndex)
     {
-        Logger::getInstance()->info(
+        LOG_INFO(
             "Response sent: status=" + std::to_string(statusCode) +
                 ", path=" + filePath +
                 ", size=" + std::to_string(fileSize) +
@@ -1235,13 +4719,136 @@ void Http::sendResponse(int client_socket, const std::string &filePath,
             clientIp);
     }
 }
+
+// read a file into the cache ahead of its first request, together with the encoded variants a response
+// would cache for it; returns the bytes cached, nothing is stored beyond budget
+size_t Http::preload(Cache *cache, const OpenFile &file, size_t budget)
+{
+    const size_t fileSize = static_cast<size_t>(file.st.st_size);
+    if (fileSize > budget)
+    {
+        return 0;
+    }
+
+    FileGuard fileGuard;
+    fileGuard.borrow(file.fd);
+    SharedBuffer identity = readFile(fileGuard, fileSize);
+    if (!identity)
+    {
+        return 0;
+    }
+    if (!cache->set(file.path, identity, file.mimeType, file.st.st_mtime))
+    {
+        return 0; // larger than a cache shard
+    }
+    size_t cached = fileSize;
+
+    // larger bodies are compressed while streaming and never cached encoded
+    if (fileSize > STREAM_COMPRESS_THRESHOLD || !Compression::shouldCompress(file.mimeType, fileSize))
+    {
+        return cached;
+    }
+
+    const uint32_t available = Compression::availableEncodings();
+    for (size_t i = static_cast<size_t>(ContentEncoding::Gzip); i < static_cast<size_t>(ContentEncoding::Count); ++i)
+    {
+        if (!(available & (1u << i)))
+        {
+            continue;
+        }
+        const auto encoding = static_cast<ContentEncoding>(i);
+        Compression compression(encoding);
+        SharedBuffer encoded = compressContent(&compression, identity);
+        if (cached + encoded->size() <= budget &&
+            cache->setVariant(file.path, encoding, encoded, file.st.st_mtime))
+        {
+            cached += encoded->size();
+        }
+    }
+    return cached;
+}
+
+// serve a build-time compressed sidecar (app.js.gz, app.js.br) zero-copy, false if it cannot be opened
+bool Http::sendPrecompressed(int client_socket, const std::string &filePath,
+                             const std::string &mimeType, ContentEncoding encoding,
+                             const std::string &clientIp, SendState &sendState,
+                             bool isIndex, const RequestConditions &conditions, const OpenFile *openFile)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    // the sidecar is its own file, its identity is the representation's entity tag
+    struct stat sidecarStat;
+    if (openFile)
+    {
+        sidecarStat = openFile->st;
+    }
+    else if (stat(filePath.c_str(), &sidecarStat) != 0)
+    {
+        return false;
+    }
+    const std::string etag = makeETag(sidecarStat);
+    sendState.encoding = encoding;
+    if (isNotModified(conditions, etag, sidecarStat.st_mtime))
+    {
+        sendState.status = 304;
+        sendNotModified(client_socket, etag, sidecarStat.st_mtime, true, clientIp, sendState);
+        return true;
+    }
+
+    FileGuard fileGuard;
+    size_t fileSize;
+    time_t lastModified;
+    if (openFile)
+    {
+        fileGuard.borrow(openFile->fd);
+        fileSize = static_cast<size_t>(sidecarStat.st_size);
+        lastModified = sidecarStat.st_mtime;
+    }
+    else if (!handleFileContent(fileGuard, filePath, fileSize, lastModified, clientIp))
+    {
+        return false;
+    }
+
+    // Socket options
+    int cork = 1;
+    SocketOptionGuard sockGuard(cork, client_socket);
+    if (!setupSocketOptions(client_socket, cork, clientIp))
+    {
+        return true;
+    }
+
+    // headers describe the original resource, the body is the encoded sidecar
+    sendState.status = 200;
+    std::string headerStr = generateHeaders(200, mimeType, fileSize, lastModified, encoding,
+                                            !sendState.closeAfterSend, false, "ETag: " + etag + "\r\n");
+    size_t totalBytesSent = sendWithWritev(client_socket, headerStr, nullptr, clientIp, sendState);
+    if (!sendState.failed)
+    {
+        totalBytesSent += sendLargeFile(client_socket, fileGuard, fileSize, clientIp, sendState);
+    }
+
+    if (isIndex)
+    {
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startTime);
+        LOG_INFO(
+            "Response sent: status=200, path=" + filePath +
+                ", size=" + std::to_string(fileSize) +
+                ", type=" + mimeType +
+                ", encoding=" + contentEncodingToken(encoding) +
+                ", time=" + std::to_string(duration.count()) + "µs" +
+                ", bytes=" + std::to_string(totalBytesSent),
+            clientIp);
+    }
+    return true;
+}
 bool Http::setupSocketOptions(int client_socket, int cork, const std::string &clientIp)
 {
     auto setSocketOption = [&](int level, int optname, const void *optval, socklen_t optlen)
     {
         if (setsockopt(client_socket, level, optname, optval, optlen) < 0)
         {
-            Logger::getInstance()->error("Failed to set socket option: " + std::string(strerror(errno)), clientIp);
+            LOG_ERROR("Failed to set socket option: " + std::string(strerror(errno)), clientIp);
             close(client_socket);
             return false;
         }
@@ -1257,7 +4864,6 @@ bool Http::setupSocketOptions(int client_socket, int cork, const std::string &cl
 
 bool Http::handleFileContent(FileGuard &fileGuard,
                              const std::string &filePath,
-                             std::pmr::vector<char> &fileContent,
                              size_t &fileSize,
                              time_t &lastModified,
                              const std::string &clientIp)
@@ -1278,7 +4884,7 @@ bool Http::handleFileContent(FileGuard &fileGuard,
 
     if (fd == -1)
     {
-        Logger::getInstance()->error(
+        LOG_ERROR(
             "Failed to open file: errno=" + std::to_string(errno),
             clientIp);
         return false;
@@ -1291,7 +4897,7 @@ bool Http::handleFileContent(FileGuard &fileGuard,
     struct stat file_stat;
     if (fstat(fd, &file_stat) == -1)
     {
-        Logger::getInstance()->error(
+        LOG_ERROR(
             "Fstat failed: errno=" + std::to_string(errno),
             clientIp);
         return false;
@@ -1302,60 +4908,62 @@ bool Http::handleFileContent(FileGuard &fileGuard,
     return true;
 }
 
-bool Http::compressContent(Middleware *middleware,
-                           const std::string &mimeType,
-                           size_t fileSize,
-                           std::pmr::vector<char> &fileContent,
-                           std::pmr::string &compressedContent,
-                           bool cacheHit,
-                           FileGuard &fileGuard,
-                           std::pmr::monotonic_buffer_resource &pool)
+// read a whole file into a buffer that can be shared with the cache
+SharedBuffer Http::readFile(FileGuard &fileGuard, size_t fileSize)
 {
-    if (cacheHit)
-    {
-        compressedContent = middleware->process(std::string(fileContent.begin(), fileContent.end()));
-    }
-    else
+    // Use aligned buffer for optimal read performance (required with O_DIRECT)
+    struct AlignedBuffer
     {
-        // Use aligned buffer with RAII
-        struct AlignedBuffer
+        void *ptr;
+        AlignedBuffer(size_t size, size_t alignment) : ptr(nullptr)
         {
-            void *ptr;
-            AlignedBuffer(size_t size, size_t alignment) : ptr(nullptr)
+            if (posix_memalign(&ptr, alignment, size) != 0)
             {
-                if (posix_memalign(&ptr, alignment, size) != 0)
-                {
-                    throw std::bad_alloc();
-                }
+                throw std::bad_alloc();
             }
-            ~AlignedBuffer() { free(ptr); }
-            void *get() { return ptr; }
-        } alignedBuffer(BUFFER_SIZE, ALIGNMENT);
+        }
+        ~AlignedBuffer() { free(ptr); }
+        void *get() { return ptr; }
+    } alignedBuffer(BUFFER_SIZE, ALIGNMENT);
 
-        std::pmr::vector<char> buffer{&pool};
-        buffer.reserve(fileSize);
+    std::vector<char> content;
+    content.reserve(fileSize);
 
-        size_t totalRead = 0;
-        while (totalRead < fileSize)
-        {
-            ssize_t bytesRead = read(fileGuard.get(), alignedBuffer.get(),
-                                     std::min(BUFFER_SIZE, fileSize - totalRead));
-            if (bytesRead <= 0)
-                break;
-            buffer.insert(buffer.end(), static_cast<char *>(alignedBuffer.get()),
-                          static_cast<char *>(alignedBuffer.get()) + bytesRead);
-            totalRead += bytesRead;
-        }
+    // pread leaves the descriptor offset alone, sendfile and mmap use explicit offsets anyway
+    size_t totalRead = 0;
+    while (totalRead < fileSize)
+    {
+        ssize_t bytesRead = pread(fileGuard.get(), alignedBuffer.get(),
+                                  std::min(BUFFER_SIZE, fileSize - totalRead), static_cast<off_t>(totalRead));
+        if (bytesRead <= 0)
+            break;
+        content.insert(content.end(), static_cast<char *>(alignedBuffer.get()),
+                       static_cast<char *>(alignedBuffer.get()) + bytesRead);
+        totalRead += bytesRead;
+    }
 
-        compressedContent = middleware->process(std::string(buffer.begin(), buffer.end()));
+    // Only hand out complete files
+    if (totalRead != fileSize)
+    {
+        return nullptr;
     }
-    return true;
+    return std::make_shared<const Buffer>(std::move(content));
+}
+
+SharedBuffer Http::compressContent(Middleware *middleware, const SharedBuffer &content)
+{
+    std::string compressed = middleware->process(std::string(content->begin(), content->end()));
+    return std::make_shared<const Buffer>(std::vector<char>(compressed.begin(), compressed.end()));
 }
+
 std::string Http::generateHeaders(int statusCode,
                                   const std::string &mimeType,
                                   size_t fileSize,
                                   time_t lastModified,
-                                  bool isCompressed)
+                                  ContentEncoding encoding,
+                                  bool keepAlive,
+                                  bool chunked,
+                                  const std::string &extraHeaders)
 {
     // Pre-allocate header string capacity
     std::string headerStr;
@@ -1371,34 +4979,28 @@ std::string Http::generateHeaders(int statusCode,
     tm_info = gmtime_r(&lastModified, &tmBuf);
     strftime(lastModifiedBuffer, sizeof(lastModifiedBuffer), "%a, %d %b %Y %H:%M:%S GMT", tm_info);
 
-    // Status message lookup using array for better performance
-    static const char *const STATUS_MESSAGES[] = {
-        "OK",                    // 200
-        nullptr,                 // 201-299
-        nullptr,                 // 300-303
-        "Not Modified",          // 304
-        nullptr,                 // 305-399
-        "Bad Request",           // 400
-        "Unauthorized",          // 401
-        nullptr,                 // 402
-        "Forbidden",             // 403
-        "Not Found",             // 404
-        nullptr,                 // 405-499
-        "Internal Server Error", // 500
-        nullptr,                 // 501-502
-        "Service Unavailable",   // 503
+    // Status message lookup, table is small enough for a linear scan
+    static constexpr std::pair<int, const char *> STATUS_MESSAGES[] = {
+        {200, "OK"},
+        {206, "Partial Content"},
+        {304, "Not Modified"},
+        {400, "Bad Request"},
+        {401, "Unauthorized"},
+        {403, "Forbidden"},
+        {404, "Not Found"},
+        {416, "Range Not Satisfiable"},
+        {500, "Internal Server Error"},
+        {503, "Service Unavailable"},
     };
 
-    const char *statusMessage;
-    if (statusCode >= 200 && statusCode < static_cast<int>(sizeof(STATUS_MESSAGES) / sizeof(char *)) + 200)
-    {
-        statusMessage = STATUS_MESSAGES[statusCode - 200];
-        if (!statusMessage)
-            statusMessage = "Unknown Status";
-    }
-    else
+    const char *statusMessage = "Unknown Status";
+    for (const auto &[code, message] : STATUS_MESSAGES)
     {
-        statusMessage = "Unknown Status";
+        if (code == statusCode)
+        {
+            statusMessage = message;
+            break;
+        }
     }
 
     // Assemble response headers using string
@@ -1407,24 +5009,27 @@ std::string Http::generateHeaders(int statusCode,
                                                                                  "Date: " +
                 std::string(timeBuffer) + "\r\n"
                                           "Content-Type: " +
-                mimeType + "\r\n"
-                           "Content-Length: " +
-                std::to_string(fileSize) + "\r\n"
-                                           "Last-Modified: " +
-                std::string(lastModifiedBuffer) + "\r\n"
-                                                  "Connection: keep-alive\r\n"
-                                                  "Keep-Alive: timeout=60, max=1000\r\n"
-                                                  "Accept-Ranges: bytes\r\n"
+                mimeType + "\r\n" +
+                (chunked ? std::string("Transfer-Encoding: chunked\r\n")
+                         : "Content-Length: " + std::to_string(fileSize) + "\r\n") +
+                "Last-Modified: " +
+                std::string(lastModifiedBuffer) + "\r\n" +
+                (keepAlive ? "Connection: keep-alive\r\n"
+                             "Keep-Alive: timeout=" +
+                                 std::to_string(KEEP_ALIVE_TIMEOUT) + ", max=" + std::to_string(KEEP_ALIVE_MAX) + "\r\n"
+                           : std::string("Connection: close\r\n")) +
+                "Accept-Ranges: bytes\r\n"
                                                   "Cache-Control: public, max-age=31536000\r\n"
                                                   "X-Content-Type-Options: nosniff\r\n"
                                                   "X-Frame-Options: SAMEORIGIN\r\n"
                                                   "X-XSS-Protection: 1; mode=block\r\n";
 
-    if (isCompressed)
+    if (const char *token = contentEncodingToken(encoding))
     {
-        headerStr += "Content-Encoding: gzip\r\n"
-                     "Vary: Accept-Encoding\r\n";
+        headerStr += std::string("Content-Encoding: ") + token + "\r\n"
+                                                                "Vary: Accept-Encoding\r\n";
     }
+    headerStr += extraHeaders;
     headerStr += "\r\n";
 
     return headerStr;
@@ -1432,11 +5037,9 @@ std::string Http::generateHeaders(int statusCode,
 
 size_t Http::sendWithWritev(int client_socket,
                             const std::string &headerStr,
-                            const std::pmr::string &compressedContent,
-                            const std::pmr::vector<char> &fileContent,
-                            bool isCompressed,
-                            bool cacheHit,
-                            const std::string &clientIp)
+                            const SharedBuffer &body,
+                            const std::string &clientIp,
+                            SendState &state)
 {
     // Optimize writev using maximum allowed iovec structures
     std::array<struct iovec, MAX_IOV> iov;
@@ -1447,211 +5050,853 @@ size_t Http::sendWithWritev(int client_socket,
     iov[iovcnt].iov_len = headerStr.size();
     iovcnt++;
 
-    // Add content to iovec if compressed or cached
-    if (isCompressed)
+    // owners pin buffers that outlive this call, others are copied if the send is parked
+    std::array<std::shared_ptr<const void>, 2> owners;
+
+    // Add in-memory content (cached or freshly encoded), pointing straight at the shared buffer
+    if (body)
     {
-        iov[iovcnt].iov_base = const_cast<char *>(compressedContent.c_str());
-        iov[iovcnt].iov_len = compressedContent.size();
+        iov[iovcnt].iov_base = const_cast<char *>(body->data());
+        iov[iovcnt].iov_len = body->size();
+        owners[iovcnt] = body;
         iovcnt++;
     }
-    else if (cacheHit)
+
+    return sendBuffers(client_socket, iov.data(), iovcnt, state, clientIp, owners.data());
+}
+
+size_t Http::sendBuffers(int client_socket, struct iovec *iov, int iovcnt,
+                         SendState &state, const std::string &clientIp,
+                         const std::shared_ptr<const void> *owners)
+{
+    size_t totalSize = 0;
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        totalSize += iov[i].iov_len;
+    }
+
+    // an earlier response is still queued, keep ordering by queuing behind it
+    bool mustQueue = state.pending();
+
+    // Send all buffers using writev, parking whatever the socket doesn't take
+    size_t totalSent = 0;
+    while (totalSent < totalSize)
     {
-        iov[iovcnt].iov_base = const_cast<char *>(fileContent.data());
-        iov[iovcnt].iov_len = fileContent.size();
-        iovcnt++;
+        ssize_t sent = mustQueue ? -1 : writev(client_socket, iov, iovcnt);
+        if (sent <= 0)
+        {
+            if (mustQueue || errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                // park the unsent tail, pinned buffers are referenced,
+                // transient ones die with this request and are copied
+                std::string copied;
+                for (int i = 0; i < iovcnt; ++i)
+                {
+                    const char *data = static_cast<const char *>(iov[i].iov_base);
+                    if (owners && owners[i])
+                    {
+                        state.chunks.push_back({owners[i], data, iov[i].iov_len});
+                        continue;
+                    }
+                    copied.assign(data, iov[i].iov_len);
+                    auto owned = std::make_shared<const std::string>(std::move(copied));
+                    state.chunks.push_back({owned, owned->data(), owned->size()});
+                }
+                return totalSent;
+            }
+            LOG_ERROR(
+                "Failed to send response: errno=" + std::to_string(errno),
+                clientIp);
+            state.failed = true;
+            return totalSent;
+        }
+        totalSent += sent;
+        state.bytesSent += sent;
+
+        // Update iovec structures with zero-copy approach
+        while (sent > 0 && iovcnt > 0)
+        {
+            if (static_cast<size_t>(sent) >= iov[0].iov_len)
+            {
+                sent -= iov[0].iov_len;
+                iovcnt--;
+                ++iov;
+                if (owners)
+                    ++owners;
+            }
+            else
+            {
+                iov[0].iov_base = static_cast<char *>(iov[0].iov_base) + sent;
+                iov[0].iov_len -= sent;
+                break;
+            }
+        }
+    }
+    return totalSent;
+}
+
+// send [offset, fileSize) of the file, fileSize is the end of the range rather than the file length for ranges
+size_t Http::sendLargeFile(int client_socket,
+                           FileGuard &fileGuard,
+                           size_t fileSize,
+                           const std::string &clientIp,
+                           SendState &state,
+                           size_t offset)
+{
+    // borrow the descriptor, it is only duplicated if the transfer has to be parked
+    state.fileFd = fileGuard.get();
+    state.ownsFile = false;
+    state.fileOffset = static_cast<off_t>(offset);
+    state.fileEnd = static_cast<off_t>(fileSize);
+
+    // headers are still queued, the whole file waits behind them
+    SendStatus status = !state.chunks.empty()
+                            ? SendStatus::WouldBlock
+                            : streamFile(client_socket, state, clientIp);
+    size_t totalSent = static_cast<size_t>(state.fileOffset) - offset;
+
+    if (status == SendStatus::WouldBlock && state.fileFd != -1)
+    {
+        state.fileFd = dup(state.fileFd); // fileGuard closes the original when the request ends
+        state.ownsFile = state.fileFd != -1;
+        if (state.fileFd == -1)
+        {
+            LOG_ERROR("Failed to park file transfer: errno=" + std::to_string(errno), clientIp);
+            state.failed = true;
+        }
+    }
+    if (status != SendStatus::WouldBlock || state.failed)
+    {
+        state.failed = state.failed || status == SendStatus::Failed;
+        state.reset();
+    }
+    return totalSent;
+}
+
+Http::SendStatus Http::streamFile(int client_socket, SendState &state, const std::string &clientIp)
+{
+    // Try sendfile with optimal chunk size while socket accepts data
+    while (state.mmapAddr == MAP_FAILED && state.fileOffset < state.fileEnd)
+    {
+        size_t chunk = std::min(SENDFILE_CHUNK, static_cast<size_t>(state.fileEnd - state.fileOffset));
+        ssize_t sent = sendfile(client_socket, state.fileFd, &state.fileOffset, chunk);
+
+        if (sent == -1)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return SendStatus::WouldBlock;
+            }
+            else if (errno == EINVAL || errno == ENOSYS)
+            {
+                // Fall back to mmap for large files with huge pages support
+                size_t fileSize = static_cast<size_t>(state.fileEnd);
+                int flags = MAP_PRIVATE;
+                if (fileSize >= 2 * 1024 * 1024) // 2MB threshold for huge pages
+                {
+                    flags |= MAP_HUGETLB;
+                }
+
+                void *mmapAddr = mmap(nullptr, fileSize, PROT_READ, flags, state.fileFd, 0);
+                if (mmapAddr == MAP_FAILED && (flags & MAP_HUGETLB))
+                {
+                    flags &= ~MAP_HUGETLB;
+                    mmapAddr = mmap(nullptr, fileSize, PROT_READ, flags, state.fileFd, 0);
+                }
+
+                if (mmapAddr == MAP_FAILED)
+                {
+                    LOG_ERROR(
+                        "Mmap failed: errno=" + std::to_string(errno),
+                        clientIp);
+                    return SendStatus::Failed;
+                }
+
+                madvise(mmapAddr, fileSize, MADV_SEQUENTIAL);
+                state.mmapAddr = mmapAddr; // mapping is owned by state from now on
+                state.mmapLength = fileSize;
+                break;
+            }
+            LOG_ERROR(
+                "Failed to send file: errno=" + std::to_string(errno),
+                clientIp);
+            return SendStatus::Failed;
+        }
+        else if (sent == 0)
+        {
+            // file shrank underneath us, response framing is broken
+            LOG_ERROR("File truncated during transfer", clientIp);
+            return SendStatus::Failed;
+        }
+        state.bytesSent += sent;
+    }
+
+    // mmap cursor continues from fileOffset
+    if (state.mmapAddr != MAP_FAILED)
+    {
+        const char *fileContent = static_cast<const char *>(state.mmapAddr);
+        while (state.fileOffset < state.fileEnd)
+        {
+            size_t chunk = std::min(BUFFER_SIZE, static_cast<size_t>(state.fileEnd - state.fileOffset));
+            ssize_t sent = send(client_socket, fileContent + state.fileOffset, chunk, MSG_NOSIGNAL);
+            if (sent == -1)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    return SendStatus::WouldBlock;
+                }
+                LOG_ERROR(
+                    "Failed to send mmap data: errno=" + std::to_string(errno),
+                    clientIp);
+                return SendStatus::Failed;
+            }
+            state.fileOffset += sent;
+            state.bytesSent += sent;
+        }
+    }
+
+    return SendStatus::Complete;
+}
+
+Http::SendStatus Http::resumeSend(int client_socket, SendState &state, const std::string &clientIp)
+{
+    // flush parked header/body chunks first, straight from the pinned buffers
+    SendStatus status = flushChunks(client_socket, state, clientIp);
+    if (status != SendStatus::Complete)
+    {
+        return status;
+    }
+
+    // then continue an on-the-fly encoded body
+    if (state.encoder)
+    {
+        status = streamEncoded(client_socket, state, clientIp);
+        if (status == SendStatus::WouldBlock)
+        {
+            return status;
+        }
+        if (status == SendStatus::Failed)
+        {
+            state.failed = true;
+            state.reset();
+            return status;
+        }
+    }
+
+    // or the file body from the parked offset
+    if (state.fileFd != -1 || state.mmapAddr != MAP_FAILED)
+    {
+        status = streamFile(client_socket, state, clientIp);
+        if (status == SendStatus::WouldBlock)
+        {
+            return status;
+        }
+        if (status == SendStatus::Failed)
+        {
+            state.failed = true;
+            state.reset();
+            return status;
+        }
     }
 
-    // Send headers and content using writev with retry logic
-    size_t totalSent = 0;
-    const size_t totalSize = headerStr.size() +
-                             (isCompressed ? compressedContent.size() : (cacheHit ? fileContent.size() : 0));
+    state.reset();
+    return SendStatus::Complete;
+}
 
-    while (totalSent < totalSize)
+Http::SendStatus Http::flushChunks(int client_socket, SendState &state, const std::string &clientIp)
+{
+    while (!state.chunks.empty())
     {
+        // file slices go out with sendfile, the memory chunks around them with writev
+        if (!state.chunks.front().data)
+        {
+            SendStatus status = sendFileSlice(client_socket, state, state.chunks.front(), clientIp);
+            if (status != SendStatus::Complete)
+            {
+                if (status == SendStatus::Failed)
+                {
+                    state.failed = true;
+                    state.reset();
+                }
+                return status;
+            }
+            state.chunks.pop_front();
+            continue;
+        }
+
+        std::array<struct iovec, MAX_IOV> iov;
+        int iovcnt = 0;
+        for (auto it = state.chunks.begin(); it != state.chunks.end() && it->data && iovcnt < MAX_IOV; ++it, ++iovcnt)
+        {
+            iov[iovcnt].iov_base = const_cast<char *>(it->data);
+            iov[iovcnt].iov_len = it->size;
+        }
+
         ssize_t sent = writev(client_socket, iov.data(), iovcnt);
-        if (sent <= 0)
+        if (sent == -1)
         {
             if (errno == EAGAIN || errno == EWOULDBLOCK)
             {
-                std::this_thread::sleep_for(std::chrono::microseconds(1000));
-                continue;
+                return SendStatus::WouldBlock;
             }
-            Logger::getInstance()->error(
+            LOG_ERROR(
                 "Failed to send response: errno=" + std::to_string(errno),
                 clientIp);
-            return totalSent;
+            state.failed = true;
+            state.reset();
+            return SendStatus::Failed;
         }
-        totalSent += sent;
 
-        // Update iovec structures with zero-copy approach
-        while (sent > 0 && iovcnt > 0)
+        // drop fully written chunks, advance into a partially written one
+        size_t written = static_cast<size_t>(sent);
+        state.bytesSent += written;
+        while (written > 0 && !state.chunks.empty() && state.chunks.front().data)
         {
-            if (static_cast<size_t>(sent) >= iov[0].iov_len)
+            SendState::Chunk &chunk = state.chunks.front();
+            if (written >= chunk.size)
             {
-                sent -= iov[0].iov_len;
-                iovcnt--;
-                std::copy(iov.begin() + 1, iov.begin() + 1 + iovcnt, iov.begin());
+                written -= chunk.size;
+                state.chunks.pop_front();
             }
             else
             {
-                iov[0].iov_base = static_cast<char *>(iov[0].iov_base) + sent;
-                iov[0].iov_len -= sent;
-                break;
+                chunk.data += written;
+                chunk.size -= written;
+                written = 0;
             }
         }
     }
-    return totalSent;
+
+    return SendStatus::Complete;
 }
-size_t Http::sendLargeFile(int client_socket,
-                           FileGuard &fileGuard,
-                           size_t fileSize,
-                           const std::string &clientIp)
-{
-    size_t totalSent = 0;
-    off_t offset = 0;
-    bool useMmap = false;
 
-    // Try sendfile with optimal chunk size and retry logic
-    while (offset < static_cast<off_t>(fileSize))
+Http::SendStatus Http::sendFileSlice(int client_socket, SendState &state, SendState::Chunk &slice,
+                                     const std::string &clientIp)
+{
+    while (slice.size > 0)
     {
-        size_t chunk = std::min(SENDFILE_CHUNK, fileSize - offset);
-        ssize_t sent = sendfile(client_socket, fileGuard.get(), &offset, chunk);
+        ssize_t sent = sendfile(client_socket, state.fileFd, &slice.fileOffset, std::min(SENDFILE_CHUNK, slice.size));
+        if (sent == -1 && (errno == EINVAL || errno == ENOSYS))
+        {
+            // no sendfile for this descriptor, bounce the slice through a buffer
+            thread_local std::vector<char> buffer(BUFFER_SIZE);
+            ssize_t bytesRead = pread(state.fileFd, buffer.data(), std::min(BUFFER_SIZE, slice.size), slice.fileOffset);
+            if (bytesRead <= 0)
+            {
+                LOG_ERROR("File truncated during transfer", clientIp);
+                return SendStatus::Failed;
+            }
+            sent = send(client_socket, buffer.data(), static_cast<size_t>(bytesRead), MSG_NOSIGNAL);
+            if (sent > 0)
+            {
+                slice.fileOffset += sent;
+            }
+        }
 
         if (sent == -1)
         {
             if (errno == EAGAIN || errno == EWOULDBLOCK)
             {
-                std::this_thread::sleep_for(std::chrono::microseconds(1000));
-                continue;
-            }
-            else if (errno == EINVAL || errno == ENOSYS)
-            {
-                useMmap = true;
-                break;
+                return SendStatus::WouldBlock;
             }
-            Logger::getInstance()->error(
+            LOG_ERROR(
                 "Failed to send file: errno=" + std::to_string(errno),
                 clientIp);
-            return totalSent;
+            return SendStatus::Failed;
         }
         else if (sent == 0)
         {
-            break;
+            LOG_ERROR("File truncated during transfer", clientIp);
+            return SendStatus::Failed;
         }
-        totalSent += sent;
+        slice.size -= static_cast<size_t>(sent);
+        state.bytesSent += sent;
+    }
+    return SendStatus::Complete;
+}
+
+// IMF-fixdate as produced by generateHeaders, the obsolete formats are not accepted
+bool Http::parseHttpDate(std::string_view value, time_t &result)
+{
+    std::string date(value);
+    struct tm tmBuf = {};
+    const char *end = strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tmBuf);
+    if (!end || *end != '\0')
+    {
+        return false;
     }
+    result = timegm(&tmBuf);
+    return result != -1;
+}
 
-    // Fall back to mmap for large files with huge pages support
-    if (useMmap)
+// strong entity tag from the file identity, each content coding is its own representation
+std::string Http::makeETag(const struct stat &fileStat, ContentEncoding encoding)
+{
+    char tag[80];
+    const char *token = contentEncodingToken(encoding);
+    snprintf(tag, sizeof(tag), "\"%llx-%llx-%llx%s%s\"",
+             static_cast<unsigned long long>(fileStat.st_ino),
+             static_cast<unsigned long long>(fileStat.st_size),
+             static_cast<unsigned long long>(fileStat.st_mtime),
+             token ? "-" : "", token ? token : "");
+    return tag;
+}
+
+// RFC 9110 section 13.2.2: If-None-Match (weak comparison) wins over If-Modified-Since
+bool Http::isNotModified(const RequestConditions &conditions, const std::string &etag, time_t lastModified)
+{
+    if (!conditions.ifNoneMatch.empty())
     {
-        int flags = MAP_PRIVATE;
-        if (fileSize >= 2 * 1024 * 1024) // 2MB threshold for huge pages
+        // the file version is what the client revalidates, so a tag of any coding of it matches
+        std::string_view current(etag);
+        current.remove_suffix(1); // closing quote
+
+        std::string_view list = conditions.ifNoneMatch;
+        while (!list.empty())
         {
-            flags |= MAP_HUGETLB;
+            size_t comma = list.find(',');
+            std::string_view tag = list.substr(0, comma);
+            list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+            while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t'))
+                tag.remove_prefix(1);
+            while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+                tag.remove_suffix(1);
+            if (tag == "*")
+            {
+                return true;
+            }
+            if (tag.substr(0, 2) == "W/")
+            {
+                tag.remove_prefix(2);
+            }
+            if (tag.size() > current.size() && tag.back() == '"' && tag.substr(0, current.size()) == current &&
+                (tag.size() == current.size() + 1 || tag[current.size()] == '-'))
+            {
+                return true;
+            }
         }
+        return false;
+    }
+
+    time_t since;
+    return !conditions.ifModifiedSince.empty() && parseHttpDate(conditions.ifModifiedSince, since) &&
+           lastModified <= since;
+}
+
+size_t Http::sendNotModified(int client_socket, const std::string &etag, time_t lastModified,
+                             bool varies, const std::string &clientIp, SendState &state)
+{
+    char timeBuffer[128], lastModifiedBuffer[128];
+    time_t now = time(nullptr);
+    struct tm tmBuf;
+    strftime(timeBuffer, sizeof(timeBuffer), "%a, %d %b %Y %H:%M:%S GMT", gmtime_r(&now, &tmBuf));
+    strftime(lastModifiedBuffer, sizeof(lastModifiedBuffer), "%a, %d %b %Y %H:%M:%S GMT", gmtime_r(&lastModified, &tmBuf));
+
+    // no body and no Content-Length, only the validators and caching headers of a 200
+    std::string response = std::string("HTTP/1.1 304 Not Modified\r\n"
+                                       "Server: RobustHTTP/1.0\r\n"
+                                       "Date: ") +
+                           timeBuffer + "\r\n"
+                                        "ETag: " +
+                           etag + "\r\n"
+                                  "Last-Modified: " +
+                           lastModifiedBuffer + "\r\n"
+                                                "Cache-Control: public, max-age=31536000\r\n" +
+                           (varies ? "Vary: Accept-Encoding\r\n" : "") +
+                           (state.closeAfterSend ? "Connection: close\r\n" : "") +
+                           "\r\n";
+
+    struct iovec iov[1];
+    iov[0].iov_base = response.data();
+    iov[0].iov_len = response.size();
+    return sendBuffers(client_socket, iov, 1, state, clientIp);
+}
+
+Http::RangeStatus Http::parseRanges(const RequestConditions &conditions, size_t size, time_t lastModified,
+                                    const std::string &etag, std::vector<ByteRange> &ranges)
+{
+    std::string_view spec = conditions.range;
+    if (spec.size() < 6 || !HttpRequest::equalsIgnoreCase(spec.substr(0, 6), "bytes="))
+    {
+        return RangeStatus::Ignored; // unknown range unit
+    }
 
-        void *mmapAddr = mmap(nullptr, fileSize, PROT_READ, flags, fileGuard.get(), 0);
-        if (mmapAddr == MAP_FAILED && (flags & MAP_HUGETLB))
+    // If-Range: the ranges only apply while the strong entity tag or the exact Last-Modified date still
+    // matches, anything else gets the full body
+    if (!conditions.ifRange.empty())
+    {
+        if (conditions.ifRange.front() == '"' || conditions.ifRange.substr(0, 2) == "W/")
         {
-            flags &= ~MAP_HUGETLB;
-            mmapAddr = mmap(nullptr, fileSize, PROT_READ, flags, fileGuard.get(), 0);
+            if (etag.empty() || conditions.ifRange != etag)
+            {
+                return RangeStatus::Ignored; // weak tags never match here
+            }
+        }
+        else
+        {
+            time_t validator;
+            if (!parseHttpDate(conditions.ifRange, validator) || validator != lastModified)
+            {
+                return RangeStatus::Ignored;
+            }
         }
+    }
 
-        if (mmapAddr == MAP_FAILED)
+    auto parseNumber = [](std::string_view digits, size_t &value)
+    {
+        if (digits.empty() || digits.size() > 19)
         {
-            Logger::getInstance()->error(
-                "Mmap failed: errno=" + std::to_string(errno),
-                clientIp);
-            return totalSent;
+            return false;
+        }
+        value = 0;
+        for (char c : digits)
+        {
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+            value = value * 10 + static_cast<size_t>(c - '0');
         }
+        return true;
+    };
 
-        // RAII for mmap
-        MMapGuard mmapGuard(mmapAddr, fileSize);
-        madvise(mmapAddr, fileSize, MADV_SEQUENTIAL);
+    spec.remove_prefix(6);
+    size_t specCount = 0;
+    while (!spec.empty())
+    {
+        size_t comma = spec.find(',');
+        std::string_view item = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t'))
+            item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t'))
+            item.remove_suffix(1);
+        if (item.empty())
+        {
+            continue;
+        }
+        if (++specCount > MAX_RANGES)
+        {
+            ranges.clear();
+            return RangeStatus::Ignored;
+        }
 
-        const char *fileContent = static_cast<const char *>(mmapAddr);
-        size_t remainingBytes = fileSize;
-        size_t bytesSent = 0;
+        size_t dash = item.find('-');
+        if (dash == std::string_view::npos)
+        {
+            ranges.clear();
+            return RangeStatus::Ignored; // malformed, ignore the whole header
+        }
 
-        while (remainingBytes > 0)
+        size_t first, last;
+        if (dash == 0)
         {
-            size_t chunk = std::min(BUFFER_SIZE, remainingBytes);
-            ssize_t sent = send(client_socket, fileContent + bytesSent, chunk, MSG_NOSIGNAL);
-            if (sent == -1)
+            // suffix range, the last N bytes
+            size_t suffix;
+            if (!parseNumber(item.substr(1), suffix))
             {
-                if (errno == EAGAIN || errno == EWOULDBLOCK)
-                {
-                    std::this_thread::sleep_for(std::chrono::microseconds(1000));
-                    continue;
-                }
-                Logger::getInstance()->error(
-                    "Failed to send mmap data: errno=" + std::to_string(errno),
-                    clientIp);
-                return totalSent + bytesSent;
+                ranges.clear();
+                return RangeStatus::Ignored;
+            }
+            if (suffix == 0 || size == 0)
+            {
+                continue; // unsatisfiable on its own
+            }
+            first = suffix >= size ? 0 : size - suffix;
+            last = size - 1;
+        }
+        else
+        {
+            if (!parseNumber(item.substr(0, dash), first))
+            {
+                ranges.clear();
+                return RangeStatus::Ignored;
+            }
+            if (dash + 1 == item.size())
+            {
+                last = size - 1; // open ended
+            }
+            else if (!parseNumber(item.substr(dash + 1), last) || last < first)
+            {
+                ranges.clear();
+                return RangeStatus::Ignored;
+            }
+            if (first >= size)
+            {
+                continue; // starts past the end
             }
-            bytesSent += sent;
-            remainingBytes -= sent;
+            last = std::min(last, size - 1);
         }
-        totalSent += bytesSent;
+        ranges.push_back({first, last});
     }
 
-    return totalSent;
+    if (specCount == 0)
+    {
+        return RangeStatus::Ignored;
+    }
+    return ranges.empty() ? RangeStatus::Unsatisfiable : RangeStatus::Satisfiable;
 }
 
-void Http::updateCache(Cache *cache,
-                       const std::string &filePath,
-                       const std::string &mimeType,
-                       time_t lastModified,
-                       FileGuard &fileGuard,
-                       size_t fileSize,
-                       std::pmr::monotonic_buffer_resource &pool)
+size_t Http::sendRanges(int client_socket,
+                        const std::string &mimeType,
+                        size_t fileSize,
+                        time_t lastModified,
+                        const std::string &etag,
+                        const std::vector<ByteRange> &ranges,
+                        const SharedBuffer &body,
+                        FileGuard &fileGuard,
+                        const std::string &clientIp,
+                        SendState &state)
 {
-    std::pmr::vector<char> content{&pool};
-    content.reserve(fileSize);
+    const bool keepAlive = !state.closeAfterSend;
+    const std::string totalSize = "/" + std::to_string(fileSize);
+    const std::string etagHeader = etag.empty() ? std::string() : "ETag: " + etag + "\r\n";
+
+    // single range: a plain 206, the body is one slice of the cached buffer or one sendfile range
+    if (ranges.size() == 1)
+    {
+        const ByteRange &range = ranges.front();
+        size_t length = range.last - range.first + 1;
+        std::string headerStr = generateHeaders(206, mimeType, length, lastModified, ContentEncoding::Identity,
+                                                keepAlive, false,
+                                                etagHeader + "Content-Range: bytes " + std::to_string(range.first) +
+                                                    "-" + std::to_string(range.last) + totalSize + "\r\n");
+        if (body)
+        {
+            struct iovec iov[2];
+            std::shared_ptr<const void> owners[2] = {nullptr, body};
+            iov[0].iov_base = headerStr.data();
+            iov[0].iov_len = headerStr.size();
+            iov[1].iov_base = const_cast<char *>(body->data() + range.first);
+            iov[1].iov_len = length;
+            return sendBuffers(client_socket, iov, 2, state, clientIp, owners);
+        }
+
+        size_t totalSent = sendWithWritev(client_socket, headerStr, nullptr, clientIp, state);
+        if (!state.failed)
+        {
+            totalSent += sendLargeFile(client_socket, fileGuard, range.last + 1, clientIp, state, range.first);
+        }
+        return totalSent;
+    }
+
+    // multipart/byteranges: part headers live in one shared string, bodies are buffer or file slices
+    thread_local std::mt19937_64 boundaryRandom(std::random_device{}());
+    char boundary[24];
+    snprintf(boundary, sizeof(boundary), "pgs%016llx", static_cast<unsigned long long>(boundaryRandom()));
+
+    auto partHeaders = std::make_shared<std::string>();
+    std::vector<std::pair<size_t, size_t>> headerSpans; // offset/length of each part header in partHeaders
+    size_t contentLength = 0;
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        size_t start = partHeaders->size();
+        partHeaders->append(i == 0 ? "--" : "\r\n--").append(boundary).append("\r\nContent-Type: ").append(mimeType);
+        partHeaders->append("\r\nContent-Range: bytes ").append(std::to_string(ranges[i].first)).append("-");
+        partHeaders->append(std::to_string(ranges[i].last)).append(totalSize).append("\r\n\r\n");
+        headerSpans.emplace_back(start, partHeaders->size() - start);
+        contentLength += partHeaders->size() - start + ranges[i].last - ranges[i].first + 1;
+    }
+    size_t closingStart = partHeaders->size();
+    partHeaders->append("\r\n--").append(boundary).append("--\r\n");
+    contentLength += partHeaders->size() - closingStart;
+
+    auto headerStr = std::make_shared<std::string>(
+        generateHeaders(206, std::string("multipart/byteranges; boundary=") + boundary, contentLength, lastModified,
+                        ContentEncoding::Identity, keepAlive, false, etagHeader));
+
+    // queue everything and let flushChunks interleave writev and sendfile
+    state.chunks.push_back({headerStr, headerStr->data(), headerStr->size()});
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        size_t length = ranges[i].last - ranges[i].first + 1;
+        state.chunks.push_back({partHeaders, partHeaders->data() + headerSpans[i].first, headerSpans[i].second});
+        if (body)
+        {
+            state.chunks.push_back({body, body->data() + ranges[i].first, length});
+        }
+        else
+        {
+            state.chunks.push_back({nullptr, nullptr, length, static_cast<off_t>(ranges[i].first)});
+        }
+    }
+    state.chunks.push_back({partHeaders, partHeaders->data() + closingStart, partHeaders->size() - closingStart});
+
+    if (!body)
+    {
+        // borrow the descriptor, duplicated below if the transfer has to be parked
+        state.fileFd = fileGuard.get();
+        state.ownsFile = false;
+        state.fileOffset = state.fileEnd = 0;
+    }
+
+    SendStatus status = flushChunks(client_socket, state, clientIp);
+    if (status == SendStatus::WouldBlock && state.fileFd != -1)
+    {
+        state.fileFd = dup(state.fileFd); // fileGuard closes the original when the request ends
+        state.ownsFile = state.fileFd != -1;
+        if (state.fileFd == -1)
+        {
+            LOG_ERROR("Failed to park range transfer: errno=" + std::to_string(errno), clientIp);
+            state.failed = true;
+        }
+    }
+    if (status != SendStatus::WouldBlock || state.failed)
+    {
+        state.failed = state.failed || status == SendStatus::Failed;
+        state.reset();
+    }
+    return status == SendStatus::Complete ? headerStr->size() + contentLength : 0;
+}
+
+size_t Http::sendEncodedStream(int client_socket,
+                               FileGuard &fileGuard,
+                               const SharedBuffer &source,
+                               size_t fileSize,
+                               std::unique_ptr<StreamEncoder> encoder,
+                               const std::string &clientIp,
+                               SendState &state)
+{
+    // the source is either a cached identity buffer or the open file, read through pread
+    state.encoder = std::move(encoder);
+    state.encodeSource = source;
+    state.fileFd = source ? -1 : fileGuard.get();
+    state.ownsFile = false;
+    state.fileOffset = 0;
+    state.fileEnd = static_cast<off_t>(fileSize);
+
+    SendStatus status = streamEncoded(client_socket, state, clientIp);
+    size_t consumed = static_cast<size_t>(state.fileOffset);
+
+    if (status == SendStatus::WouldBlock && state.fileFd != -1)
+    {
+        state.fileFd = dup(state.fileFd); // fileGuard closes the original when the request ends
+        state.ownsFile = state.fileFd != -1;
+        if (state.fileFd == -1 && state.encoder)
+        {
+            LOG_ERROR("Failed to park encoded transfer: errno=" + std::to_string(errno), clientIp);
+            state.failed = true;
+        }
+    }
+    if (status != SendStatus::WouldBlock || state.failed)
+    {
+        state.failed = state.failed || status == SendStatus::Failed;
+        state.reset();
+    }
+    return consumed;
+}
+
+Http::SendStatus Http::streamEncoded(int client_socket, SendState &state, const std::string &clientIp)
+{
+    thread_local std::vector<char> input(BUFFER_SIZE);
 
-    if (lseek(fileGuard.get(), 0, SEEK_SET) != -1)
+    // encode one input block at a time and only once the previous output has left, so at most one
+    // block of input and its encoded chunk are held per connection
+    while (true)
     {
-        // Use aligned buffer for optimal read performance
-        std::unique_ptr<char[]> alignedBuffer(new (std::align_val_t{ALIGNMENT}) char[BUFFER_SIZE]);
-        size_t totalRead = 0;
+        SendStatus status = flushChunks(client_socket, state, clientIp);
+        if (status != SendStatus::Complete || !state.encoder)
+        {
+            return status;
+        }
 
-        while (totalRead < fileSize)
+        size_t length = std::min(BUFFER_SIZE, static_cast<size_t>(state.fileEnd - state.fileOffset));
+        const char *data = input.data();
+        if (state.encodeSource)
+        {
+            data = state.encodeSource->data() + state.fileOffset;
+        }
+        else if (length > 0)
         {
-            ssize_t bytesRead = read(fileGuard.get(), alignedBuffer.get(),
-                                     std::min(BUFFER_SIZE, fileSize - totalRead));
+            ssize_t bytesRead = pread(state.fileFd, input.data(), length, state.fileOffset);
             if (bytesRead <= 0)
-                break;
+            {
+                // file shrank underneath us, the encoded body cannot be completed
+                LOG_ERROR("File truncated during transfer", clientIp);
+                return SendStatus::Failed;
+            }
+            length = static_cast<size_t>(bytesRead);
+        }
+        state.fileOffset += static_cast<off_t>(length);
+        const bool finish = state.fileOffset >= state.fileEnd;
 
-            content.insert(content.end(), alignedBuffer.get(),
-                           alignedBuffer.get() + bytesRead);
-            totalRead += bytesRead;
+        // frame the encoder output as one chunk, the terminating chunk follows the trailer
+        auto framed = std::make_shared<std::string>();
+        try
+        {
+            std::string encoded;
+            state.encoder->write(data, length, finish, encoded);
+            if (!encoded.empty())
+            {
+                char size[20];
+                int sizeLength = snprintf(size, sizeof(size), "%zx\r\n", encoded.size());
+                framed->reserve(sizeLength + encoded.size() + 7);
+                framed->append(size, sizeLength).append(encoded).append("\r\n");
+            }
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR(std::string("Streaming compression failed: ") + e.what(), clientIp);
+            return SendStatus::Failed;
         }
 
-        // Only update cache if we read the entire file
-        if (totalRead == fileSize)
+        if (finish)
         {
-            cache->set(filePath, content, mimeType, lastModified);
+            framed->append("0\r\n\r\n");
+
+            // source is no longer needed, only the queued output remains
+            state.encoder.reset();
+            state.encodeSource.reset();
+            if (state.ownsFile && state.fileFd != -1)
+                close(state.fileFd);
+            state.fileFd = -1;
+            state.ownsFile = false;
         }
+        if (!framed->empty())
+        {
+            state.chunks.push_back({framed, framed->data(), framed->size()});
+        }
+    }
+}
+
+void Http::updateCache(Cache *cache,
+                       const std::string &filePath,
+                       const std::string &mimeType,
+                       time_t lastModified,
+                       FileGuard &fileGuard,
+                       size_t fileSize)
+{
+    // read into a shared buffer so it can be handed to the cache without another copy
+    if (SharedBuffer content = readFile(fileGuard, fileSize))
+    {
+        cache->set(filePath, std::move(content), mimeType, lastModified);
     }
 }
 
 class Router
 {
 public:
-    Router(const std::string &staticFolder) : staticFolder(staticFolder)
+    Router(const std::string &staticFolder, FileCache *fileCache) : staticFolder(staticFolder), fileCache(fileCache)
     {
-        Logger::getInstance()->success("Router initialized with static folder: " + staticFolder);
+        LOG_SUCCESS("Router initialized with static folder: " + staticFolder);
     }
-    void route(const std::string &path, int client_socket, const std::string &clientIp, Middleware *middleware, Cache *cache);
+    void route(const std::string &path, int client_socket, const std::string &clientIp, Middleware *middleware, Cache *cache,
+               SendState &sendState, const AcceptEncoding &acceptEncoding = {},
+               const RequestConditions &conditions = {});
     [[nodiscard]]
     std::string getStaticFolder() const
     {
         return staticFolder;
     }
+    static std::string getMimeType(const std::string &path); // get MIME type based on file extension
 
 private:
-    std::string staticFolder;                         // path to static files
-    std::string getMimeType(const std::string &path); // get MIME type based on file extension
+    std::string staticFolder; // path to static files
+    FileCache *fileCache;     // open descriptors and metadata of served files
+    ContentEncoding findSidecar(const OpenFile &file, const AcceptEncoding &acceptEncoding, uint16_t minQuality,
+                                std::shared_ptr<const OpenFile> &sidecar); // locate a precompressed .br/.zst/.gz next to the file
 };
 
 [[nodiscard]]
@@ -1734,8 +5979,48 @@ std::string Router::getMimeType(const std::string &path)
     return it != mimeTypes.end() ? std::string(it->second) : TEXT_PLAIN;
 }
 
+ContentEncoding Router::findSidecar(const OpenFile &file, const AcceptEncoding &acceptEncoding, uint16_t minQuality,
+                                   std::shared_ptr<const OpenFile> &sidecar)
+{
+    static constexpr std::pair<ContentEncoding, const char *> SIDECARS[] = {
+        {ContentEncoding::Brotli, ".br"},
+        {ContentEncoding::Zstd, ".zst"},
+        {ContentEncoding::Gzip, ".gz"}};
+
+    // highest client quality first, server preference (listed order) between equals
+    std::array<std::pair<ContentEncoding, const char *>, std::size(SIDECARS)> candidates;
+    std::copy(std::begin(SIDECARS), std::end(SIDECARS), candidates.begin());
+    std::stable_sort(candidates.begin(), candidates.end(), [&](const auto &a, const auto &b)
+                     { return acceptEncoding.qualityOf(a.first) > acceptEncoding.qualityOf(b.first); });
+
+    for (const auto &[encoding, suffix] : candidates)
+    {
+        uint16_t quality = acceptEncoding.qualityOf(encoding);
+        if (quality == 0 || quality < minQuality)
+        {
+            break; // sorted, nothing acceptable follows
+        }
+
+        // absent sidecars are remembered by the file cache, probing costs no syscall
+        sidecar = fileCache->openExact(file.path + suffix);
+        if (!sidecar)
+        {
+            continue;
+        }
+
+        // a sidecar older than its source is a leftover from a previous build
+        if (sidecar->st.st_mtime >= file.st.st_mtime)
+        {
+            return encoding;
+        }
+    }
+    sidecar.reset();
+    return ContentEncoding::Identity;
+}
+
 void Router::route(const std::string &path, int client_socket, const std::string &clientIp,
-                   Middleware *middleware, Cache *cache)
+                   Middleware *middleware, Cache *cache, SendState &sendState, const AcceptEncoding &acceptEncoding,
+                   const RequestConditions &conditions)
 {
     // pre-allocate string capacity to avoid reallocation
     // +11 accounts for potential "/index.html" addition
@@ -1753,21 +6038,22 @@ void Router::route(const std::string &path, int client_socket, const std::string
     // this avoids string copies during comparisons
     std::string_view pathView(normalizedPath);
 
-    // cache filesystem check results to avoid redundant calls
-    bool isDir = fs::is_directory(filePath);
+    // one cached lookup resolves directories to their index.html and opens the file
+    std::shared_ptr<const OpenFile> file = fileCache->open(filePath);
+    bool isDir = file && file->directory;
     bool isIndex = (pathView == "/index.html" || pathView == "/" || isDir);
     bool isAsset = Http::isAssetRequest(normalizedPath);
 
-    // append index.html for directory paths
-    if (isDir)
+    // serve and cache under the resolved path, the form the static folder watcher reports changes in
+    if (file)
     {
-        filePath += "/index.html";
+        filePath = file->path;
     }
 
     // log non-asset index requests
     if (!isAsset && isIndex)
     {
-        Logger::getInstance()->info("Processing request: " + path, clientIp);
+        LOG_DEBUG("Processing request: " + path, clientIp);
     }
 
     // static response for 404 errors
@@ -1786,12 +6072,14 @@ void Router::route(const std::string &path, int client_socket, const std::string
     static bool has404File = false;
 
     // check if file exists and handle 404 errors
-    if (!fs::exists(filePath) || (isDir && !fs::exists(filePath)))
+    if (!file)
     {
+        sendState.status = 404;
+
         // log warning for non-asset requests
         if (!isAsset)
         {
-            Logger::getInstance()->warning("File not found: " + filePath, clientIp);
+            LOG_WARNING("File not found: " + filePath, clientIp);
         }
 
         // initialize 404.html content only once
@@ -1811,8 +6099,10 @@ void Router::route(const std::string &path, int client_socket, const std::string
         // send simple 404 response if custom 404.html doesn't exist
         if (!has404File)
         {
-            // use MSG_NOSIGNAL to prevent SIGPIPE
-            send(client_socket, SIMPLE_404_RESPONSE, strlen(SIMPLE_404_RESPONSE), MSG_NOSIGNAL);
+            struct iovec iov[1];
+            iov[0].iov_base = const_cast<char *>(SIMPLE_404_RESPONSE);
+            iov[0].iov_len = strlen(SIMPLE_404_RESPONSE);
+            Http::sendBuffers(client_socket, iov, 1, sendState, clientIp);
             return;
         }
 
@@ -1821,13 +6111,13 @@ void Router::route(const std::string &path, int client_socket, const std::string
         static const std::string RESPONSE_404_HEADER =
             "HTTP/1.1 404 Not Found\r\n"
             "Content-Type: text/html\r\n"
-            "Connection: close\r\n"
             "Content-Length: ";
 
         // use writev for efficient response sending
         // this minimizes the number of system calls
         struct iovec iov[4]; // array of io vectors for writev
-        std::string contentLength = std::to_string(cached404Content.size());
+        std::string contentLength = std::to_string(cached404Content.size()) +
+                                    (sendState.closeAfterSend ? "\r\nConnection: close" : "");
         static const char *CRLF = "\r\n\r\n";
 
         // set up io vectors for response components
@@ -1840,22 +6130,41 @@ void Router::route(const std::string &path, int client_socket, const std::string
         iov[3].iov_base = const_cast<char *>(cached404Content.data());
         iov[3].iov_len = cached404Content.size();
 
-        // send all components in a single system call
-        if (writev(client_socket, iov, 4) == -1)
+        // send all components, parking the tail if the socket is full
+        Http::sendBuffers(client_socket, iov, 4, sendState, clientIp);
+        return;
+    }
+
+    // mime type was resolved when the file was opened
+    const std::string &mimeType = file->mimeType;
+
+    // prefer a build-time compressed sidecar, streamed with sendfile and never touching the compressor,
+    // unless the client weights the runtime coding (or identity) higher
+    ContentEncoding runtimeEncoding = middleware ? middleware->contentEncoding() : ContentEncoding::Identity;
+    if (conditions.range.empty() && Compression::shouldCompress(mimeType, std::numeric_limits<size_t>::max()))
+    {
+        std::shared_ptr<const OpenFile> sidecar;
+        ContentEncoding encoding = findSidecar(*file, acceptEncoding, acceptEncoding.qualityOf(runtimeEncoding),
+                                               sidecar);
+        if (encoding != ContentEncoding::Identity &&
+            Http::sendPrecompressed(client_socket, sidecar->path, mimeType, encoding, clientIp, sendState,
+                                    !isAsset && isIndex, conditions, sidecar.get()))
         {
-            Logger::getInstance()->error("Failed to send 404 response: " + std::string(strerror(errno)), clientIp);
+            return;
         }
-        return;
     }
 
-    // get mime type and send response
-    // note: getmimetype is assumed to be case-insensitive
-    std::string mimeType = getMimeType(filePath);
+    // no runtime coding the client takes and identity refused
+    if (runtimeEncoding == ContentEncoding::Identity && !acceptEncoding.identityAllowed() && conditions.range.empty())
+    {
+        Http::sendError(client_socket, 406, sendState, clientIp);
+        return;
+    }
 
     // send the response using the optimized http::sendresponse method
     // the !isasset && isindex parameter determines whether to log the response
-    Http::sendResponse(client_socket, filePath, mimeType, 200, clientIp,
-                       !isAsset && isIndex, middleware, cache);
+    Http::sendResponse(client_socket, filePath, mimeType, 200, clientIp, sendState,
+                       !isAsset && isIndex, middleware, cache, conditions, file.get());
 }
 
 class Parser
@@ -1867,13 +6176,13 @@ public:
 Config Parser::parseConfig(const std::string &configFilePath)
 {
     // log start of configuration reading process
-    Logger::getInstance()->info("Reading configuration from: " + configFilePath);
+    LOG_INFO("Reading configuration from: " + configFilePath);
 
     // open  configuration file
     std::ifstream file(configFilePath);
     if (!file.is_open())
     {
-        Logger::getInstance()->error("Could not open config file: " + configFilePath);
+        LOG_ERROR("Could not open config file: " + configFilePath);
         throw std::runtime_error("Could not open config file!");
     }
 
@@ -1885,7 +6194,7 @@ Config Parser::parseConfig(const std::string &configFilePath)
     }
     catch (const json::parse_error &e)
     {
-        Logger::getInstance()->error("JSON parsing error: " + std::string(e.what()));
+        LOG_ERROR("JSON parsing error: " + std::string(e.what()));
         throw std::runtime_error("Failed to parse configuration file");
     }
 
@@ -1900,7 +6209,7 @@ Config Parser::parseConfig(const std::string &configFilePath)
         !configJson["cache"].contains("size_mb") || configJson["cache"]["size_mb"].is_null() ||
         !configJson["cache"].contains("max_age_seconds") || configJson["cache"]["max_age_seconds"].is_null())
     {
-        Logger::getInstance()->error("Configuration file is missing required fields or contains null values");
+        LOG_ERROR("Configuration file is missing required fields or contains null values");
         throw std::runtime_error("Incomplete configuration file");
     }
 
@@ -1909,62 +6218,139 @@ Config Parser::parseConfig(const std::string &configFilePath)
     config.port = configJson["port"];
     config.staticFolder = configJson["static_folder"];
     config.threadCount = configJson["thread_count"];
+    config.reactorPerCore = configJson.value("reactor_per_core", false); // optional, defaults to shared dispatcher
     config.rateLimit.maxRequests = configJson["rate_limit"]["max_requests"];
     config.rateLimit.timeWindow = configJson["rate_limit"]["time_window"];
     config.cache.sizeMB = configJson["cache"]["size_mb"].get<size_t>();
     config.cache.maxAgeSeconds = configJson["cache"]["max_age_seconds"].get<int>();
+    config.cache.snapshot = configJson["cache"].value("snapshot", std::string()); // optional
+    const std::string admission = configJson["cache"].value("admission", std::string("tinylfu")); // optional
+    if (admission != "tinylfu" && admission != "none")
+    {
+        LOG_ERROR("Invalid cache admission policy: " + admission + ", expected tinylfu or none");
+        throw std::runtime_error("Invalid cache admission policy");
+    }
+    config.cache.admission = admission == "tinylfu";
+
+    // optional per-coding levels
+    json compressionJson = configJson.value("compression", json::object());
+    config.compression.gzipLevel = compressionJson.value("gzip_level", 6);
+    config.compression.brotliLevel = compressionJson.value("brotli_level", 5);
+    config.compression.zstdLevel = compressionJson.value("zstd_level", 3);
+
+    // optional descriptor cache
+    json fileCacheJson = configJson.value("file_cache", json::object());
+    config.fileCache.maxEntries = fileCacheJson.value("max_entries", size_t(1024));
+    config.fileCache.revalidateMs = fileCacheJson.value("revalidate_ms", 1000);
+
+    // optional startup preload
+    json warmupJson = configJson.value("warmup", json::object());
+    config.warmup.enabled = warmupJson.value("enabled", false);
+    config.warmup.manifest = warmupJson.value("manifest", std::string());
+    config.warmup.deadlineMs = warmupJson.value("deadline_ms", 10000);
+
+    // optional binary access log
+    json accessLogJson = configJson.value("access_log", json::object());
+    config.accessLog.path = accessLogJson.value("path", std::string());
+    config.accessLog.maxMB = accessLogJson.value("max_mb", size_t(64));
+    config.accessLog.keep = accessLogJson.value("keep", 4);
+
+    // optional log level and sinks
+    json loggingJson = configJson.value("logging", json::object());
+    config.logging.level = loggingJson.value("level", std::string("info"));
+    config.logging.file = loggingJson.value("file", std::string("pgs.log"));
+    config.logging.console = loggingJson.value("console", true);
+    config.logging.syslog = loggingJson.value("syslog", std::string());
 
     // validate port number
     if (config.port <= 0 || config.port > 65535)
     {
-        Logger::getInstance()->error("Invalid port number: " + std::to_string(config.port));
+        LOG_ERROR("Invalid port number: " + std::to_string(config.port));
         throw std::runtime_error("Invalid port number");
     }
 
     // validate static folder path
     if (!fs::exists(config.staticFolder))
     {
-        Logger::getInstance()->error("Static folder does not exist: " + config.staticFolder);
+        LOG_ERROR("Static folder does not exist: " + config.staticFolder);
         throw std::runtime_error("Invalid static folder path");
     }
 
     // validate thread count
     if (config.threadCount <= 0 || config.threadCount > 1000)
     {
-        Logger::getInstance()->error("Invalid thread count: " + std::to_string(config.threadCount));
+        LOG_ERROR("Invalid thread count: " + std::to_string(config.threadCount));
         throw std::runtime_error("Invalid thread count");
     }
 
     // validate maximum requests for rate limiting
     if (config.rateLimit.maxRequests <= 0)
     {
-        Logger::getInstance()->error("Invalid max requests for rate limiting: " + std::to_string(config.rateLimit.maxRequests));
+        LOG_ERROR("Invalid max requests for rate limiting: " + std::to_string(config.rateLimit.maxRequests));
         throw std::runtime_error("Invalid max requests for rate limiting");
     }
 
     // validate time window for rate limiting
     if (config.rateLimit.timeWindow <= 0)
     {
-        Logger::getInstance()->error("Invalid time window for rate limiting: " + std::to_string(config.rateLimit.timeWindow));
+        LOG_ERROR("Invalid time window for rate limiting: " + std::to_string(config.rateLimit.timeWindow));
         throw std::runtime_error("Invalid time window for rate limiting");
     }
 
     // validate cache size
     if (config.cache.sizeMB <= 0 || config.cache.sizeMB > std::numeric_limits<size_t>::max() / (1024 * 1024))
     {
-        Logger::getInstance()->error("Invalid cache size: " + std::to_string(config.cache.sizeMB) + " MB");
-        throw std::runtime_error("Invalid cache size");
+        LOG_ERROR("Invalid cache size: " + std::to_string(config.cache.sizeMB) + " MB");
+        throw std::runtime_error("Invalid cache size");
+    }
+
+    // validate cache max age
+    if (config.cache.maxAgeSeconds <= 0)
+    {
+        LOG_ERROR("Invalid cache max age: " + std::to_string(config.cache.maxAgeSeconds) + " seconds");
+        throw std::runtime_error("Invalid cache max age");
+    }
+
+    // validate compression levels
+    if (config.compression.gzipLevel < 1 || config.compression.gzipLevel > 9 ||
+        config.compression.brotliLevel < 0 || config.compression.brotliLevel > 11 ||
+        config.compression.zstdLevel < 1 || config.compression.zstdLevel > 22)
+    {
+        LOG_ERROR("Invalid compression level, expected gzip 1-9, brotli 0-11, zstd 1-22");
+        throw std::runtime_error("Invalid compression level");
+    }
+
+    // validate file cache, every entry may hold a descriptor
+    if (config.fileCache.maxEntries == 0 || config.fileCache.maxEntries > 1000000 || config.fileCache.revalidateMs < 0)
+    {
+        LOG_ERROR("Invalid file cache settings, expected max_entries 1-1000000 and revalidate_ms >= 0");
+        throw std::runtime_error("Invalid file cache settings");
+    }
+
+    // validate warm-up deadline
+    if (config.warmup.deadlineMs <= 0)
+    {
+        LOG_ERROR("Invalid warm-up deadline: " + std::to_string(config.warmup.deadlineMs) + " ms");
+        throw std::runtime_error("Invalid warm-up deadline");
+    }
+
+    // validate access log rotation, the whole file is mapped at once
+    if (config.accessLog.maxMB == 0 || config.accessLog.maxMB > 16384 || config.accessLog.keep < 0 ||
+        config.accessLog.keep > 1000)
+    {
+        LOG_ERROR("Invalid access log settings, expected max_mb 1-16384 and keep 0-1000");
+        throw std::runtime_error("Invalid access log settings");
     }
 
-    // validate cache max age
-    if (config.cache.maxAgeSeconds <= 0)
+    // validate log level
+    if (!Logger::parseLevel(config.logging.level))
     {
-        Logger::getInstance()->error("Invalid cache max age: " + std::to_string(config.cache.maxAgeSeconds) + " seconds");
-        throw std::runtime_error("Invalid cache max age");
+        LOG_ERROR("Invalid log level: " + config.logging.level + ", expected debug, info, success, warning or error");
+        throw std::runtime_error("Invalid log level");
     }
 
     // log successful configuration loading
-    Logger::getInstance()->success("Configuration loaded successfully");
+    LOG_SUCCESS("Configuration loaded successfully");
 
     // return populated and validated Config object
     return config;
@@ -2084,51 +6470,316 @@ private:
 class Server
 {
 public:
-    Server(int port, const std::string &staticFolder, int threadCount, int maxRequests, int timeWindow, int cacheSizeMB, int maxAgeSeconds);
+    Server(int port, const std::string &staticFolder, int threadCount, int maxRequests, int timeWindow, int cacheSizeMB, int maxAgeSeconds,
+           bool reactorPerCore = false, size_t fileCacheEntries = 1024, int fileRevalidateMs = 1000,
+           const std::string &snapshotPath = "", bool cacheAdmission = true, const std::string &accessLogPath = "",
+           size_t accessLogMaxMB = 64, int accessLogKeep = 4);
+    void warmUp(const std::string &manifest, std::chrono::milliseconds deadline);
     void start();
     void stop();
 
 private:
-    Socket socket;                             // server socket
-    Router router;                             // server router instance
-    ThreadPool pool;                           // server thread pool
-    EpollWrapper epoll;                        // server epoll instance
-    RateLimiter rateLimiter;                   // server rate limiter
-    Cache cache;                               // server cache
-    std::mutex connectionsMutex;               // mutex to protect connections map
-    std::map<int, ConnectionInfo> connections; // map to store connection info
-    std::atomic<bool> shouldStop{false};       // atomic flag to stop server
-
-    void handleClient(int client_socket, const std::string &clientIp);
+    // per-core reactor: its own SO_REUSEPORT listener and epoll instance,
+    // accepted connections are served end to end on the reactor thread
+    struct Reactor
+    {
+        Socket socket;      // reactor listening socket
+        EpollWrapper epoll; // reactor epoll instance
+        std::thread thread; // reactor thread
+
+        explicit Reactor(int port) : socket(port), epoll() {}
+    };
+
+    Socket socket;                                  // server socket
+    FileCache fileCache;                            // open descriptors of served files, used by router
+    Router router;                                  // server router instance
+    ThreadPool pool;                                // server thread pool
+    EpollWrapper epoll;                             // server epoll instance
+    RateLimiter rateLimiter;                        // server rate limiter
+    Cache cache;                                    // server cache
+    std::unique_ptr<CacheSnapshot> snapshot;        // persisted cache contents, nullptr when disabled
+    std::unique_ptr<AccessLog> accessLog;           // binary per-request records, nullptr when disabled
+    FileWatcher watcher;                            // inotify watch of the static folder
+    std::thread housekeeper;                        // applies watcher changes and cache expiry
+    ConnectionTable connections;                    // open connections indexed by socket descriptor
+    TrafficCounters traffic;                        // server-wide connection and byte totals
+    std::atomic<bool> shouldStop{false};            // atomic flag to stop server
+    std::atomic<int> runningLoops{0};               // event loops still running, connections are closed once none are
+    bool reactorPerCore;                            // one event loop per worker instead of a shared dispatcher
+    std::vector<std::unique_ptr<Reactor>> reactors; // additional reactors (the first one uses socket/epoll above)
+
+    void eventLoop(Socket &listener, EpollWrapper &ep, bool dispatchToPool);
+    void handleClient(int client_socket);
+    void processRequest(int client_socket, const std::string &clientIp, const HttpRequest &request, SendState &sendState);
+    void closeIdleConnections(EpollWrapper &ep);
+    void releaseConnection(int client_socket, EpollWrapper &ep, bool wantWrite);
+    void beginAccess(ConnectionInfo &connection, std::string_view path);
+    void finishAccess(ConnectionInfo &connection);
+    void housekeeping();
+    void logCacheStats();
+    void logTraffic();
     void closeConnection(int client_socket);
     void logRequest(int client_socket, const std::string &message);
+    static void pinToCore(std::thread &thread, size_t index);
 };
 
-Server::Server(int port, const std::string &staticFolder, int threadCount, int maxRequests, int timeWindow, int cacheSizeMB, int maxAgeSeconds)
+Server::Server(int port, const std::string &staticFolder, int threadCount, int maxRequests, int timeWindow, int cacheSizeMB, int maxAgeSeconds,
+               bool reactorPerCore, size_t fileCacheEntries, int fileRevalidateMs, const std::string &snapshotPath,
+               bool cacheAdmission, const std::string &accessLogPath, size_t accessLogMaxMB, int accessLogKeep)
     : socket(port),
-      router(staticFolder),
+      fileCache(fileCacheEntries, std::chrono::milliseconds(fileRevalidateMs), &Router::getMimeType),
+      router(staticFolder, &fileCache),
       pool(threadCount),
       epoll(),
       rateLimiter(maxRequests, std::chrono::seconds(timeWindow)),
-      cache(cacheSizeMB, std::chrono::seconds(maxAgeSeconds))
+      cache(cacheSizeMB, std::chrono::seconds(maxAgeSeconds), cacheAdmission),
+      watcher(staticFolder),
+      reactorPerCore(reactorPerCore)
 {
     std::ostringstream oss;
     oss << "Creating dual-stack server on port: " << port
         << "\n   static folder: " << staticFolder
         << "\n   thread count: " << threadCount
+        << ", mode: " << (reactorPerCore ? "reactor per core" : "shared dispatcher")
         << ", rate limit: " << maxRequests << " requests per " << timeWindow << " seconds"
         << "\n   cache size: " << cacheSizeMB << "MB"
-        << ", cache max age: " << maxAgeSeconds << " seconds";
+        << ", cache max age: " << maxAgeSeconds << " seconds"
+        << ", admission: " << (cacheAdmission ? "tinylfu" : "none");
+
+    LOG_INFO(oss.str());
+
+    // bring back the previous run's cache before anything is served or warmed up
+    if (!snapshotPath.empty())
+    {
+        snapshot = std::make_unique<CacheSnapshot>(snapshotPath);
+        snapshot->load(cache);
+    }
+
+    if (!accessLogPath.empty())
+    {
+        accessLog = std::make_unique<AccessLog>(accessLogPath, accessLogMaxMB << 20, accessLogKeep);
+    }
 
-    Logger::getInstance()->info(oss.str());
     socket.bind();
     socket.listen();
+
+    // every reactor binds its own listener to the same port (SO_REUSEPORT),
+    // the primary socket above doubles as the first reactor's listener
+    if (reactorPerCore)
+    {
+        for (int i = 1; i < threadCount; ++i)
+        {
+            auto reactor = std::make_unique<Reactor>(port);
+            reactor->socket.bind();
+            reactor->socket.listen();
+            reactors.push_back(std::move(reactor));
+        }
+    }
 }
 
 void Server::start()
 {
-    Logger::getInstance()->success("Server starting up...");
+    LOG_SUCCESS("Server starting up...");
+    housekeeper = std::thread([this]
+                              { housekeeping(); });
+
+    if (!reactorPerCore)
+    {
+        eventLoop(socket, epoll, true);
+    }
+    else
+    {
+        // spawn additional reactors, the calling thread runs the first one
+        for (size_t i = 0; i < reactors.size(); ++i)
+        {
+            Reactor &reactor = *reactors[i];
+            reactor.thread = std::thread([this, &reactor]
+                                         { eventLoop(reactor.socket, reactor.epoll, false); });
+            pinToCore(reactor.thread, i + 1);
+        }
+
+        eventLoop(socket, epoll, false);
+
+        for (auto &reactor : reactors)
+        {
+            if (reactor->thread.joinable())
+            {
+                reactor->thread.join();
+            }
+        }
+    }
+
+    if (housekeeper.joinable())
+    {
+        housekeeper.join();
+    }
+    LOG_INFO("Server is shutting down...");
+}
+
+// fill the caches before the first connection is accepted, from a manifest of hot request paths
+// (one per line, optionally followed by a hit count) or from every file under the static folder;
+// files are loaded and compressed in parallel on the pool until the cache budget or the deadline runs out
+void Server::warmUp(const std::string &manifest, std::chrono::milliseconds deadline)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    const std::string staticFolder = router.getStaticFolder();
+
+    std::vector<std::string> paths;
+    if (!manifest.empty())
+    {
+        std::ifstream in(manifest);
+        if (!in)
+        {
+            LOG_WARNING("Cannot open warm-up manifest: " + manifest);
+            return;
+        }
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream fields(line);
+            std::string path;
+            if (!(fields >> path) || path.front() != '/' || path.find("..") != std::string::npos)
+            {
+                continue; // blank, comment or not a request path
+            }
+            paths.push_back(staticFolder + path);
+        }
+    }
+    else
+    {
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(staticFolder, fs::directory_options::skip_permission_denied, ec);
+             !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
+        {
+            const std::string extension = it->path().extension().string();
+            if (it->is_regular_file(ec) && extension != ".gz" && extension != ".br" && extension != ".zst")
+            {
+                paths.push_back(it->path().string()); // sidecars are sent from disk, not cached
+            }
+        }
+    }
+
+    // shared with the tasks, which may still be queued when the deadline passes
+    struct Progress
+    {
+        std::atomic<bool> cancelled{false};
+        std::atomic<size_t> bytes{0};
+        std::atomic<size_t> files{0};
+    };
+    auto progress = std::make_shared<Progress>();
+    const size_t budget = cache.getStats().maxSize;
+
+    std::vector<std::future<void>> pending;
+    pending.reserve(paths.size());
+    for (auto &path : paths)
+    {
+        pending.push_back(pool.enqueue([this, progress, budget, path = std::move(path)]
+                                       {
+            const size_t used = progress->bytes.load(std::memory_order_relaxed);
+            if (progress->cancelled.load(std::memory_order_relaxed) || used >= budget)
+            {
+                return;
+            }
+            auto file = fileCache.open(path);
+            if (!file || cache.exists(file->path))
+            {
+                return; // missing, or restored from the snapshot
+            }
+            if (size_t cached = Http::preload(&cache, *file, budget - used))
+            {
+                progress->bytes.fetch_add(cached, std::memory_order_relaxed);
+                progress->files.fetch_add(1, std::memory_order_relaxed);
+            } }));
+    }
+
+    bool completed = true;
+    for (auto &task : pending)
+    {
+        if (task.wait_until(startTime + deadline) == std::future_status::timeout)
+        {
+            completed = false;
+            break;
+        }
+    }
+    progress->cancelled.store(true, std::memory_order_relaxed);
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    std::string summary = std::to_string(progress->files.load()) + " of " + std::to_string(pending.size()) +
+                          " files, " + std::to_string(progress->bytes.load() / 1024) + "KB in " +
+                          std::to_string(duration.count()) + "ms";
+    if (completed)
+    {
+        LOG_SUCCESS("Cache warm-up loaded " + summary);
+    }
+    else
+    {
+        LOG_WARNING("Cache warm-up deadline reached, loaded " + summary);
+    }
+}
+
+// drop cached copies of files that changed under the static folder, and cache entries past maxAge;
+// the next request for a path reopens and rereads it
+void Server::housekeeping()
+{
+    const auto purgeInterval = std::clamp<std::chrono::seconds>(cache.getMaxAge() / 4, std::chrono::seconds(1),
+                                                                std::chrono::seconds(60));
+    auto lastPurge = std::chrono::steady_clock::now();
+    auto lastStats = lastPurge;
+    uint64_t reportedRequests = 0;
+
+    while (!shouldStop)
+    {
+        watcher.poll(500, [this](const std::string &path, bool tree)
+                     {
+            size_t removed = tree ? cache.removeTree(path) : static_cast<size_t>(cache.remove(path));
+            removed += fileCache.invalidate(path, tree); // includes .br/.zst/.gz sidecars and negative entries
+            if (removed > 0)
+            {
+                LOG_INFO("Invalidated " + std::to_string(removed) + " cached entries for " + path);
+            } });
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastPurge >= purgeInterval)
+        {
+            if (size_t expired = cache.purgeExpired())
+            {
+                LOG_INFO("Expired " + std::to_string(expired) + " cache entries");
+            }
+            lastPurge = now;
+        }
+
+        // once a minute while there is traffic
+        if (now - lastStats >= std::chrono::minutes(1))
+        {
+            const Cache::CacheStats stats = cache.getStats();
+            if (stats.hits + stats.misses != reportedRequests)
+            {
+                logCacheStats();
+                reportedRequests = stats.hits + stats.misses;
+            }
+            lastStats = now;
+        }
+    }
+}
+
+void Server::pinToCore(std::thread &thread, size_t index)
+{
+    const unsigned cores = std::thread::hardware_concurrency();
+    if (cores == 0)
+        return;
 
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(index % cores, &cpuset);
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpuset), &cpuset) != 0)
+    {
+        LOG_WARNING("Failed to pin reactor " + std::to_string(index) + " to a core");
+    }
+}
+
+void Server::eventLoop(Socket &listener, EpollWrapper &ep, bool dispatchToPool)
+{
+    runningLoops.fetch_add(1);
     try
     {
         // pre-allocate events array with optimal size
@@ -2136,54 +6787,65 @@ void Server::start()
         struct epoll_event events[MAX_EVENTS];
 
         // add server socket to epoll
-        epoll.add(socket.getSocketFd(), EPOLLIN);
-        Logger::getInstance()->success("Server is ready and waiting for connections...");
+        ep.add(listener.getSocketFd(), EPOLLIN);
+        LOG_SUCCESS("Server is ready and waiting for connections...");
+
+        auto lastIdleSweep = std::chrono::steady_clock::now();
 
         while (!shouldStop)
         {
             // use shorter timeout for better responsiveness
-            int nfds = epoll.wait(events, MAX_EVENTS, 50);
+            int nfds = ep.wait(events, MAX_EVENTS, 50);
+
+            // enforce keep-alive timeout about once per second
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastIdleSweep >= std::chrono::seconds(1))
+            {
+                closeIdleConnections(ep);
+                lastIdleSweep = now;
+            }
 
             if (nfds == -1)
             {
                 if (errno == EINTR)
                     continue;
-                Logger::getInstance()->error("Epoll wait failed: " + std::string(strerror(errno)));
+                LOG_ERROR("Epoll wait failed: " + std::string(strerror(errno)));
                 break;
             }
 
             for (int i = 0; i < nfds; ++i)
             {
-                if (events[i].data.fd == socket.getSocketFd())
+                if (events[i].data.fd == listener.getSocketFd())
                 {
                     // handle new connection
                     std::string clientIp;
-                    int client_socket = socket.acceptConnection(clientIp);
+                    struct in6_addr clientAddress;
+                    int client_socket = listener.acceptConnection(clientIp, clientAddress);
                     if (client_socket < 0)
                         continue;
 
-                    // add connection info under lock
+                    ConnectionTable::Slot *slot = connections.acquire(client_socket);
+                    if (!slot)
                     {
-                        std::lock_guard<std::mutex> lock(connectionsMutex);
-                        connections.emplace(
-                            client_socket,
-                            ConnectionInfo{
-                                std::chrono::steady_clock::now(),
-                                clientIp,
-                                false,
-                                false,
-                                0,
-                                0}); // add connection info
+                        LOG_ERROR("Socket descriptor beyond connection table", clientIp);
+                        close(client_socket);
+                        continue;
                     }
 
-                    try
+                    // add connection info under the slot lock
                     {
-                        // add to epoll with edge-triggered mode
-                        epoll.add(client_socket, EPOLLIN | EPOLLET);
+                        std::lock_guard<std::mutex> lock(slot->mutex);
+                        slot->info.emplace(std::chrono::steady_clock::now(), clientIp);
+                        slot->info->address = clientAddress;
+                        slot->info->epoll = &ep;
+                        slot->info->sendState = std::make_shared<SendState>();
                     }
-                    catch (const std::exception &e)
+                    traffic.add(1, 0, 0);
+
+                    // add to epoll with edge-triggered mode, one-shot when workers take turns on it
+                    if (!ep.add(client_socket, EPOLLIN | EPOLLET | (dispatchToPool ? EPOLLONESHOT : 0)))
                     {
-                        Logger::getInstance()->error("Failed to add client socket to epoll: " + std::string(e.what()));
+                        LOG_ERROR("Failed to add client socket to epoll: " + std::string(strerror(errno)));
                         closeConnection(client_socket);
                         continue;
                     }
@@ -2192,23 +6854,35 @@ void Server::start()
                 {
                     // handle existing connection
                     int client_socket = events[i].data.fd;
-                    std::string clientIp;
+                    ConnectionTable::Slot *slot = connections.find(client_socket);
+                    if (!slot)
+                        continue;
 
-                    // get client IP under lock
+                    // take ownership under the slot lock, a connection already
+                    // scheduled on a worker is never handed to a second one
+                    bool dispatch = false;
                     {
-                        std::lock_guard<std::mutex> lock(connectionsMutex);
-                        auto it = connections.find(client_socket);
-                        if (it != connections.end())
+                        std::lock_guard<std::mutex> lock(slot->mutex);
+                        if (slot->info && !slot->info->scheduled)
                         {
-                            clientIp = it->second.ip;
+                            slot->info->scheduled = dispatchToPool;
+                            dispatch = true;
                         }
                     }
 
-                    // enqueue client handling task
-                    if (!clientIp.empty())
+                    if (!dispatch)
+                        continue;
+
+                    if (dispatchToPool)
                     {
-                        pool.enqueue([this, client_socket, clientIp]
-                                     { handleClient(client_socket, clientIp); });
+                        // hand the connection to a worker, nothing waits for the result
+                        pool.submit([this, client_socket]
+                                    { handleClient(client_socket); });
+                    }
+                    else
+                    {
+                        // reactor owns the connection, serve it inline
+                        handleClient(client_socket);
                     }
                 }
             }
@@ -2216,161 +6890,401 @@ void Server::start()
     }
     catch (const std::exception &e)
     {
-        Logger::getInstance()->error("Server error: " + std::string(e.what()));
+        LOG_ERROR("Server error: " + std::string(e.what()));
     }
-
-    Logger::getInstance()->info("Server is shutting down...");
+    runningLoops.fetch_sub(1);
 }
 
 void Server::stop()
 {
-    Logger::getInstance()->warning("Initiating server shutdown...");
+    LOG_WARNING("Initiating server shutdown...");
     shouldStop = true;
 
     socket.closeSocket(); // stop accepting new connections
+    for (auto &reactor : reactors)
+    {
+        reactor->socket.closeSocket();
+    }
+
+    // event loops notice shouldStop within one epoll timeout, after that
+    // nothing but the workers touches a connection
+    while (runningLoops.load() > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
 
-    pool.stop(); // stop worker threads
+    pool.stop(); // stop worker threads once they drained what the dispatcher handed them
 
     // Close all existing connections
     std::vector<int> socketsToClose;
-    {
-        std::lock_guard<std::mutex> lock(connectionsMutex); // lock scope
-        for (const auto &[client_socket, _] : connections)
-        {
-            socketsToClose.push_back(client_socket);
-        }
-    }
+    connections.forEach([&socketsToClose](int client_socket, const ConnectionInfo &)
+                        { socketsToClose.push_back(client_socket); });
 
     for (int socket : socketsToClose)
     {
         closeConnection(socket);
     }
 
-    Logger::getInstance()->info("All connections closed");
+    LOG_INFO("All connections closed");
+
+    logTraffic();
+    logCacheStats();
+    if (snapshot)
+    {
+        snapshot->save(cache);
+    }
+}
+
+// hit ratio and admission counters since start, to compare admission policies on real traffic
+void Server::logCacheStats()
+{
+    const Cache::CacheStats stats = cache.getStats();
+    char ratio[16];
+    snprintf(ratio, sizeof(ratio), "%.2f%%", stats.hitRatio() * 100.0);
+    LOG_INFO("Cache stats: hit ratio " + std::string(ratio) +
+             " (" + std::to_string(stats.hits) + " hits, " + std::to_string(stats.misses) +
+             " misses), admitted " + std::to_string(stats.admitted) +
+             ", rejected " + std::to_string(stats.rejected) +
+             ", evicted " + std::to_string(stats.evicted) +
+             ", " + std::to_string(stats.itemCount) + " entries, " +
+             std::to_string(stats.currentSize / 1024) + "KB of " +
+             std::to_string(stats.maxSize / 1024) + "KB");
+}
+
+// connection and byte totals since start, summed from the per-thread counters
+void Server::logTraffic()
+{
+    const TrafficCounters::Totals totals = traffic.totals();
+    LOG_INFO("Traffic: " + std::to_string(totals.connections) + " connections, " +
+             std::to_string(totals.bytesReceived) + " bytes received, " +
+             std::to_string(totals.bytesSent) + " bytes sent");
 }
 
-void Server::handleClient(int client_socket, const std::string &clientIp)
+// the calling thread owns the connection until it is released or closed: its info stays
+// in place and the parser, counters and log buffer are used without the slot lock
+void Server::handleClient(int client_socket)
 {
-    std::vector<char> buffer(1024); // initialize buffer for reading client data
-    ssize_t valread;                // variable to store number of bytes read
-    std::string request;            // string to accumulate complete client request
-    bool connectionClosed = false;  // flag to track if connection has been closed
+    ConnectionTable::Slot *slot = connections.find(client_socket);
+    if (!slot)
+    {
+        return;
+    }
 
-    // read data from client in a loop
-    while ((valread = read(client_socket, buffer.data(), buffer.size())) > 0)
+    ConnectionInfo *connection = nullptr;
     {
-        // check if server should stop and while reading data
-        if (shouldStop)
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        if (!slot->info || !slot->info->sendState)
         {
-            closeConnection(client_socket);
             return;
         }
+        connection = &*slot->info;
+        connection->lastActivity = std::chrono::steady_clock::now();
+    }
 
-        // append read data to request string
-        request.append(buffer.data(), valread);
+    const std::string &clientIp = connection->ip;
+    std::shared_ptr<SendState> sendState = connection->sendState;      // response state of this connection
+    EpollWrapper *ep = connection->epoll ? connection->epoll : &epoll; // epoll instance watching this connection
 
-        // update bytes received for this connection
-        std::lock_guard<std::mutex> lock(connectionsMutex);
-        auto it = connections.find(client_socket);
-        if (it != connections.end())
+    // finish a parked response before reading the next request
+    if (sendState->pending())
+    {
+        switch (Http::resumeSend(client_socket, *sendState, clientIp))
         {
-            it->second.bytesReceived += valread;
+        case Http::SendStatus::WouldBlock:
+            releaseConnection(client_socket, *ep, true); // wait for next EPOLLOUT
+            return;
+        case Http::SendStatus::Failed:
+            closeConnection(client_socket);
+            return;
+        case Http::SendStatus::Complete:
+            finishAccess(*connection);
+            if (sendState->closeAfterSend)
+            {
+                closeConnection(client_socket);
+                return;
+            }
+            break;
         }
     }
 
-    // check if connection has been closed by client
-    if (valread == 0 || (valread < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
-    {
-        closeConnection(client_socket);
-        connectionClosed = true;
-    }
+    // continues from whatever an earlier wakeup left unparsed
+    RequestParser &parser = connection->parser;
 
-    // process request if connection is still open and we have received data
-    if (!connectionClosed && !request.empty())
+    HttpRequest request; // views into parser's buffer
+    bool drained = false;
+    while (!drained && !sendState->pending())
     {
-        std::string path = Http::getRequestPath(request); // extract request path
-        bool isAsset = Http::isAssetRequest(path);        // check if it's an asset request
-
-        // log non-asset requests
-        if (!isAsset)
+        // read straight into the connection buffer until EAGAIN or the read window is full
+        while (parser.buffered() < RequestParser::READ_LIMIT)
         {
-            logRequest(client_socket, "Processing request: " + path);
+            ssize_t valread = read(client_socket, parser.prepareRead(RequestParser::READ_CHUNK), RequestParser::READ_CHUNK);
+            if (valread > 0)
+            {
+                parser.commitRead(static_cast<size_t>(valread));
+                connection->bytesReceived += valread;
+                continue;
+            }
+
+            // check if connection has been closed by client or server is stopping
+            if (valread == 0 || (errno != EAGAIN && errno != EWOULDBLOCK) || shouldStop)
+            {
+                closeConnection(client_socket);
+                return;
+            }
+            drained = true;
+            break;
         }
 
-        // apply rate limiting to request
-        std::string processedRequest = rateLimiter.process(request);
+        // answer complete requests in order, stop as soon as a response has to be parked
+        while (!sendState->pending())
+        {
+            RequestParser::Status status = parser.next(request);
+            if (status == RequestParser::Status::Incomplete)
+            {
+                break; // wait for the rest of the request
+            }
+            if (status != RequestParser::Status::Complete)
+            {
+                static constexpr int ERROR_STATUS[] = {0, 0, 400, 431, 413, 501}; // indexed by RequestParser::Status
+                beginAccess(*connection, std::string_view()); // logged when the connection closes behind it
+                logRequest(client_socket, "Rejected request with status " +
+                                              std::to_string(ERROR_STATUS[static_cast<int>(status)]));
+                sendState->closeAfterSend = true;
+                Http::sendError(client_socket, ERROR_STATUS[static_cast<int>(status)], *sendState, clientIp);
+                parser.clear();
+                break;
+            }
+
+            uint32_t requestCount = ++connection->requestCount;
+
+            // announce Connection: close on the last response this connection will get
+            sendState->closeAfterSend = shouldStop || requestCount >= static_cast<uint32_t>(Http::KEEP_ALIVE_MAX) ||
+                                        !request.keepAlive();
+            sendState->chunkedAllowed = request.version == "HTTP/1.1";
+
+            beginAccess(*connection, request.path);
+            processRequest(client_socket, clientIp, request, *sendState);
+            if (!sendState->pending())
+            {
+                finishAccess(*connection);
+            }
+            parser.consume(request.length);
+
+            if (sendState->closeAfterSend)
+            {
+                parser.clear(); // nothing after the last response will be answered
+                break;
+            }
+        }
 
-        // check if request was rate limited
-        if (processedRequest == "HTTP/1.1 429 Too Many Requests\r\n"
-                                "Content-Type: text/plain\r\n"
-                                "Content-Length: 19\r\n"
-                                "\r\n"
-                                "Too Many Requests")
+        if (sendState->failed || (sendState->closeAfterSend && !sendState->pending()))
         {
-            // send rate limit response to client
-            send(client_socket, processedRequest.c_str(), processedRequest.size(), 0);
+            closeConnection(client_socket);
+            return;
         }
-        else
+        if (sendState->closeAfterSend)
         {
-            // create a compression middleware instance
-            Compression compressionMiddleware;
-            // route request with compression middleware
-            router.route(path, client_socket, clientIp, &compressionMiddleware, &cache);
+            break;
         }
+    }
 
-        // log completion of non-asset requests
-        if (!isAsset)
+    // a full socket buffer is resumed from the reactor on EPOLLOUT
+    releaseConnection(client_socket, *ep, sendState->pending());
+}
+
+// start the access record of a request, the response outcome is reset in its SendState
+void Server::beginAccess(ConnectionInfo &connection, std::string_view path)
+{
+    SendState &sendState = *connection.sendState;
+    sendState.status = 0;
+    sendState.cacheHit = false;
+    sendState.encoding = ContentEncoding::Identity;
+    if (!accessLog)
+    {
+        return;
+    }
+    ConnectionInfo::PendingAccess &access = connection.access;
+    access.active = true;
+    access.path.assign(path);
+    access.start = std::chrono::system_clock::now();
+    access.started = std::chrono::steady_clock::now();
+    access.bytesBefore = sendState.bytesSent;
+}
+
+// write the access record once the response is complete, failed or cut off by a close
+void Server::finishAccess(ConnectionInfo &connection)
+{
+    ConnectionInfo::PendingAccess &access = connection.access;
+    if (!access.active)
+    {
+        return;
+    }
+    access.active = false;
+
+    const SendState &sendState = *connection.sendState;
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - access.started);
+    accessLog->append({access.start, &connection.address, access.path, sendState.status, sendState.cacheHit,
+                       sendState.encoding, sendState.bytesSent - access.bytesBefore,
+                       static_cast<uint32_t>(std::min<int64_t>(latency.count(), UINT32_MAX))});
+}
+
+// hand the connection back to its event loop: watch writability only while a response is
+// parked, and re-arm a one-shot socket together with clearing the owner so the next event
+// can't reach a second worker before this one is done
+void Server::releaseConnection(int client_socket, EpollWrapper &ep, bool wantWrite)
+{
+    ConnectionTable::Slot *slot = connections.find(client_socket);
+    if (!slot)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (!slot->info)
+    {
+        return;
+    }
+
+    ConnectionInfo &info = *slot->info;
+    if (info.scheduled || info.writeArmed != wantWrite)
+    {
+        uint32_t events = EPOLLIN | EPOLLET | (wantWrite ? EPOLLOUT : 0) | (info.scheduled ? EPOLLONESHOT : 0);
+        ep.modify(client_socket, events);
+        info.writeArmed = wantWrite;
+    }
+    info.scheduled = false;
+}
+
+void Server::processRequest(int client_socket, const std::string &clientIp, const HttpRequest &request, SendState &sendState)
+{
+    // static server, anything but GET is refused
+    if (request.method != "GET")
+    {
+        logRequest(client_socket, "Method not allowed: " + std::string(request.method));
+        Http::sendError(client_socket, 405, sendState, clientIp);
+        return;
+    }
+
+    std::string path(request.path);            // extract request path
+    bool isAsset = Http::isAssetRequest(path); // check if it's an asset request
+
+    // apply rate limiting to request
+    std::string processedRequest = rateLimiter.process(std::string(request.raw));
+
+    // check if request was rate limited
+    if (processedRequest == "HTTP/1.1 429 Too Many Requests\r\n"
+                            "Content-Type: text/plain\r\n"
+                            "Content-Length: 17\r\n"
+                            "\r\n"
+                            "Too Many Requests")
+    {
+        // send rate limit response to client
+        sendState.status = 429;
+        struct iovec iov[1];
+        iov[0].iov_base = processedRequest.data();
+        iov[0].iov_len = processedRequest.size();
+        Http::sendBuffers(client_socket, iov, 1, sendState, clientIp);
+    }
+    else
+    {
+        // compress with the best registered coding the client accepts
+        AcceptEncoding acceptEncoding = AcceptEncoding::parse(request.header("Accept-Encoding"));
+        ContentEncoding encoding = acceptEncoding.choose(Compression::availableEncodings());
+        Compression compressionMiddleware(encoding, !acceptEncoding.identityAllowed());
+        Middleware *middleware = encoding != ContentEncoding::Identity ? &compressionMiddleware : nullptr;
+        // range and validator headers travel with the request into the response
+        RequestConditions conditions;
+        conditions.range = request.header("Range");
+        conditions.ifRange = request.header("If-Range");
+        conditions.ifNoneMatch = request.header("If-None-Match");
+        conditions.ifModifiedSince = request.header("If-Modified-Since");
+
+        // route request with compression middleware
+        router.route(path, client_socket, clientIp, middleware, &cache, sendState, acceptEncoding, conditions);
+    }
+
+    // log completion of non-asset requests
+    if (!isAsset)
+    {
+        LOG_DEBUG("Request completed: " + path, clientIp);
+    }
+}
+
+void Server::closeIdleConnections(EpollWrapper &ep)
+{
+    const auto deadline = std::chrono::steady_clock::now() - std::chrono::seconds(Http::KEEP_ALIVE_TIMEOUT);
+
+    std::vector<int> idleSockets;
+    connections.forEach([&](int client_socket, const ConnectionInfo &info)
+                        {
+        if (info.epoll == &ep && !info.scheduled && info.lastActivity < deadline)
         {
-            logRequest(client_socket, "Request completed: " + path);
-        }
+            idleSockets.push_back(client_socket);
+        } });
+
+    for (int client_socket : idleSockets)
+    {
+        closeConnection(client_socket);
     }
 }
 
 void Server::closeConnection(int client_socket)
 {
-    std::lock_guard<std::mutex> lock(connectionsMutex); // lock scope
-    auto it = connections.find(client_socket);          // find client socket
-    if (it != connections.end())
+    EpollWrapper *ep = &epoll;
+    ConnectionTable::Slot *slot = connections.find(client_socket);
+    std::unique_lock<std::mutex> lock;
+    if (slot)
+    {
+        lock = std::unique_lock<std::mutex>(slot->mutex); // held until the descriptor is closed, so it can't be reused meanwhile
+    }
+
+    if (slot && slot->info)
     {
-        if (!it->second.isClosureLogged)
+        ConnectionInfo &info = *slot->info;
+        if (info.epoll)
+        {
+            ep = info.epoll;
+        }
+        if (info.sendState)
+        {
+            info.bytesSent = info.sendState->bytesSent;
+            finishAccess(info); // a response that never completed is recorded with what was written
+        }
+
+        if (!info.isClosureLogged)
         {
-            auto duration = std::chrono::steady_clock::now() - it->second.startTime;
+            auto duration = std::chrono::steady_clock::now() - info.startTime;
             std::string durationStr = Socket::durationToString(duration);
 
-            for (const auto &message : it->second.logBuffer) // log all buffered messages first
+            for (const auto &message : info.logBuffer) // log all buffered messages first
             {
-                Logger::getInstance()->info(message, it->second.ip);
+                LOG_INFO(message, info.ip);
             }
 
-            Logger::getInstance()->info(
+            LOG_INFO(
                 "Connection closed - Duration: " + durationStr +
-                    ", Bytes received: " + std::to_string(it->second.bytesReceived) +
-                    ", Bytes sent: " + std::to_string(it->second.bytesSent),
-                it->second.ip); // always log connection closure
+                    ", Requests: " + std::to_string(info.requestCount) +
+                    ", Bytes received: " + std::to_string(info.bytesReceived) +
+                    ", Bytes sent: " + std::to_string(info.bytesSent),
+                info.ip); // always log connection closure
 
-            it->second.isClosureLogged = true;
+            info.isClosureLogged = true;
         }
-        connections.erase(it); // erase connection info
-    }
-
-    try
-    {
-        epoll.remove(client_socket); // remove client socket from epoll
-    }
-    catch (const std::exception &e)
-    {
-        Logger::getInstance()->warning("Failed to remove client socket from epoll: " + std::string(e.what()));
+        traffic.add(0, info.bytesReceived, info.bytesSent);
+        slot->info.reset(); // erase connection info
     }
 
+    ep->remove(client_socket); // remove client socket from epoll
     close(client_socket);
 }
 
+// only called by the connection's owner, so the log buffer needs no lock
 void Server::logRequest(int client_socket, const std::string &message)
 {
-    std::lock_guard<std::mutex> lock(connectionsMutex);
-    auto it = connections.find(client_socket); // find client socket
-    if (it != connections.end())
-        it->second.logBuffer.push_back(message);
+    ConnectionTable::Slot *slot = connections.find(client_socket);
+    if (slot && slot->info)
+        slot->info->logBuffer.push_back(message);
 }
 
 std::unique_ptr<Server> server; // instance of Server
@@ -2386,16 +7300,30 @@ int main(void)
 {
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+    signal(SIGPIPE, SIG_IGN); // writev to a peer that went away must fail with EPIPE, not kill the server
 
     try
     {
         Config config = Parser::parseConfig("pgs_conf.json"); // parse configuration file
+        Logger::getInstance()->configure(*Logger::parseLevel(config.logging.level), config.logging.file,
+                                         config.logging.console, config.logging.syslog); // replaces the default sinks
+        Compression::configure(config.compression.gzipLevel, config.compression.brotliLevel,
+                               config.compression.zstdLevel); // register encoders before any worker runs
         server = std::make_unique<Server>(config.port, config.staticFolder, config.threadCount,
                                           config.rateLimit.maxRequests, config.rateLimit.timeWindow,
-                                          config.cache.sizeMB, config.cache.maxAgeSeconds); // create server instance
+                                          config.cache.sizeMB, config.cache.maxAgeSeconds,
+                                          config.reactorPerCore, config.fileCache.maxEntries,
+                                          config.fileCache.revalidateMs, config.cache.snapshot,
+                                          config.cache.admission, config.accessLog.path, config.accessLog.maxMB,
+                                          config.accessLog.keep); // create server instance
 
         std::thread serverThread([&]()
-                                 { server->start(); }); // start server in a separate thread
+                                 {
+            if (config.warmup.enabled)
+            {
+                server->warmUp(config.warmup.manifest, std::chrono::milliseconds(config.warmup.deadlineMs));
+            }
+            server->start(); }); // start server in a separate thread, ready once warm-up is done
 
         while (running)
         {
@@ -2411,7 +7339,7 @@ int main(void)
         }
         else
         {
-            Logger::getInstance()->error("Failed to join shutdown thread");
+            LOG_ERROR("Failed to join shutdown thread");
         }
 
         if (serverThread.joinable()) // join server thread
@@ -2420,16 +7348,16 @@ int main(void)
         }
         else
         {
-            Logger::getInstance()->error("Failed to join server thread");
+            LOG_ERROR("Failed to join server thread");
         }
     }
     catch (const std::exception &e)
     {
-        Logger::getInstance()->error("Fatal error: " + std::string(e.what()));
+        LOG_ERROR("Fatal error: " + std::string(e.what()));
         return EXIT_FAILURE;
     }
 
-    Logger::getInstance()->info("Server shut down successfully");
+    LOG_INFO("Server shut down successfully");
     server.reset();            // explicitly destroy server object
     Logger::destroyInstance(); // destroy logger instance
 
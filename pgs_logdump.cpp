@@ -0,0 +1,227 @@
+#include <cstdio>        // printf, fwrite - buffered output
+#include <cstring>       // memcpy, strcmp
+#include <cerrno>        // errno
+#include <algorithm>     // std::min
+#include <ctime>         // gmtime_r, strftime
+#include <string>        // std::string
+#include <vector>        // path table
+#include <sys/mman.h>    // mmap - to read log files in place
+#include <sys/stat.h>    // fstat - file size
+#include <fcntl.h>       // open
+#include <unistd.h>      // close
+#include <arpa/inet.h>   // inet_ntop
+#include "access_log.h"
+
+// Dump pgs binary access logs as CSV (default) or JSON lines:
+//     pgs_logdump [--json] file...
+
+namespace
+{
+    // quote a CSV field when it contains a separator, quote or line break
+    void appendCsv(std::string &out, const std::string &value)
+    {
+        if (value.find_first_of(",\"\r\n") == std::string::npos)
+        {
+            out += value;
+            return;
+        }
+        out += '"';
+        for (char c : value)
+        {
+            if (c == '"')
+            {
+                out += '"';
+            }
+            out += c;
+        }
+        out += '"';
+    }
+
+    void appendJsonString(std::string &out, const std::string &value)
+    {
+        out += '"';
+        for (unsigned char c : value)
+        {
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            default:
+                if (c < 0x20)
+                {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                }
+                else
+                {
+                    out += static_cast<char>(c);
+                }
+            }
+        }
+        out += '"';
+    }
+
+    // ISO 8601 UTC with microseconds
+    std::string formatTimestamp(uint64_t timestampUs)
+    {
+        const time_t seconds = static_cast<time_t>(timestampUs / 1000000);
+        struct tm utc;
+        gmtime_r(&seconds, &utc);
+        char date[32];
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &utc);
+        char result[48];
+        snprintf(result, sizeof(result), "%s.%06uZ", date, static_cast<unsigned>(timestampUs % 1000000));
+        return result;
+    }
+
+    std::string formatAddress(const uint8_t *address)
+    {
+        char text[INET6_ADDRSTRLEN];
+        if (!inet_ntop(AF_INET6, address, text, sizeof(text)))
+        {
+            return "-";
+        }
+        return text;
+    }
+
+    bool dumpFile(const char *path, bool json, std::string &out)
+    {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            fprintf(stderr, "pgs_logdump: cannot open %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < AccessLogFormat::SLOT_SIZE)
+        {
+            fprintf(stderr, "pgs_logdump: %s is not an access log\n", path);
+            close(fd);
+            return false;
+        }
+        const size_t length = static_cast<size_t>(st.st_size);
+        void *addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            fprintf(stderr, "pgs_logdump: cannot map %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        const char *base = static_cast<const char *>(addr);
+
+        AccessLogFormat::FileHeader header;
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, AccessLogFormat::MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != AccessLogFormat::VERSION || header.slotSize != AccessLogFormat::SLOT_SIZE)
+        {
+            fprintf(stderr, "pgs_logdump: %s is not an access log of this version\n", path);
+            munmap(addr, length);
+            return false;
+        }
+
+        std::vector<std::string> paths; // indexed by path id
+        size_t offset = AccessLogFormat::SLOT_SIZE;
+        while (offset + AccessLogFormat::SLOT_SIZE <= length)
+        {
+            const uint8_t type = static_cast<uint8_t>(base[offset]);
+            if (type == AccessLogFormat::Path)
+            {
+                AccessLogFormat::PathRecord record;
+                memcpy(&record, base + offset, sizeof(record));
+                const size_t slots = AccessLogFormat::pathSlots(record.length);
+                if (offset + slots * AccessLogFormat::SLOT_SIZE > length)
+                {
+                    break; // cut off
+                }
+                const size_t head = std::min<size_t>(record.length, sizeof(record.text));
+                std::string text(record.text, head);
+                text.append(base + offset + sizeof(record), record.length - head);
+                if (record.pathId >= paths.size())
+                {
+                    paths.resize(record.pathId + 1);
+                }
+                paths[record.pathId] = std::move(text);
+                offset += slots * AccessLogFormat::SLOT_SIZE;
+                continue;
+            }
+            offset += AccessLogFormat::SLOT_SIZE;
+            if (type != AccessLogFormat::Access)
+            {
+                continue; // never written
+            }
+
+            AccessLogFormat::AccessRecord record;
+            memcpy(&record, base + offset - AccessLogFormat::SLOT_SIZE, sizeof(record));
+            const std::string &requestPath = record.pathId < paths.size() ? paths[record.pathId] : std::string();
+            const char *encoding = record.encoding < AccessLogFormat::ENCODING_COUNT
+                                       ? AccessLogFormat::ENCODINGS[record.encoding]
+                                       : "unknown";
+            const char *cache = record.cacheHit ? "HIT" : "MISS";
+            if (json)
+            {
+                out += "{\"timestamp\":\"" + formatTimestamp(record.timestampUs) + "\",\"client\":\"" +
+                       formatAddress(record.address) + "\",\"path\":";
+                appendJsonString(out, requestPath);
+                out += ",\"status\":" + std::to_string(record.status) + ",\"bytes\":" + std::to_string(record.bytes) +
+                       ",\"cache\":\"" + cache + "\",\"encoding\":\"" + encoding +
+                       "\",\"latency_us\":" + std::to_string(record.latencyUs) + "}\n";
+            }
+            else
+            {
+                out += formatTimestamp(record.timestampUs) + "," + formatAddress(record.address) + ",";
+                appendCsv(out, requestPath);
+                out += "," + std::to_string(record.status) + "," + std::to_string(record.bytes) + "," + cache + "," +
+                       encoding + "," + std::to_string(record.latencyUs) + "\n";
+            }
+
+            if (out.size() >= (1 << 20))
+            {
+                fwrite(out.data(), 1, out.size(), stdout);
+                out.clear();
+            }
+        }
+
+        munmap(addr, length);
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+        {
+            json = true;
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty())
+    {
+        fprintf(stderr, "usage: pgs_logdump [--json] file...\n");
+        return 2;
+    }
+
+    std::string out;
+    if (!json)
+    {
+        out = "timestamp,client,path,status,bytes,cache,encoding,latency_us\n";
+    }
+    bool ok = true;
+    for (const char *file : files)
+    {
+        ok = dumpFile(file, json, out) && ok;
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    return ok ? 0 : 1;
+}